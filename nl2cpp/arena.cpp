@@ -0,0 +1,92 @@
+﻿#include "stdafx.h"
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace {
+// Los bloques crecen al doble hasta este tamaño
+constexpr std::size_t maxBlockSize = 4 * 1024 * 1024;
+}
+
+// ==================== CONSTRUCTOR ====================
+Arena::Arena(std::size_t firstBlockSize)
+    : nextBlockSize(std::max<std::size_t>(firstBlockSize, 256))
+{
+}
+
+Arena::~Arena() {}
+
+Arena::Arena(Arena&& other) noexcept
+    : blocks(std::move(other.blocks)),
+      nextBlockSize(other.nextBlockSize),
+      cursor(other.cursor),
+      limit(other.limit)
+{
+    other.blocks.clear();
+    other.cursor = other.limit = nullptr;
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+    if (this != &other) {
+        blocks = std::move(other.blocks);
+        nextBlockSize = other.nextBlockSize;
+        cursor = other.cursor;
+        limit = other.limit;
+        other.blocks.clear();
+        other.cursor = other.limit = nullptr;
+    }
+    return *this;
+}
+
+// ==================== RESERVA ====================
+
+void* Arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    auto align = [alignment](char* p) {
+        const std::uintptr_t value = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<char*>((value + alignment - 1) & ~std::uintptr_t(alignment - 1));
+    };
+
+    char* start = cursor ? align(cursor) : nullptr;
+    if (!start || bytes > std::size_t(limit - start)) {
+        addBlock(bytes + alignment);
+        start = align(cursor);
+    }
+
+    cursor = start + bytes;
+    return start;
+}
+
+void Arena::addBlock(std::size_t minBytes)
+{
+    const std::size_t size = std::max(nextBlockSize, minBytes);
+    blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+    cursor = blocks.back().data.get();
+    limit = cursor + size;
+
+    nextBlockSize = std::min(nextBlockSize * 2, maxBlockSize);
+}
+
+void Arena::reset()
+{
+    if (blocks.empty()) return;
+
+    auto largest = std::max_element(blocks.begin(), blocks.end(),
+        [](const Block& a, const Block& b) { return a.size < b.size; });
+    Block kept = std::move(*largest);
+    blocks.clear();
+    blocks.push_back(std::move(kept));
+
+    cursor = blocks.back().data.get();
+    limit = cursor + blocks.back().size;
+}
+
+std::size_t Arena::bytesReserved() const
+{
+    std::size_t total = 0;
+    for (const Block& b : blocks) total += b.size;
+    return total;
+}
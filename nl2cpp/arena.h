@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Vista de solo lectura sobre un arreglo contiguo guardado en un Arena
+template <typename T>
+struct ArenaSpan {
+    const T* items = nullptr;
+    std::size_t count = 0;
+
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](std::size_t i) const { return items[i]; }
+};
+
+// Reserva por bloques grandes con puntero incremental. Nada se libera de forma
+// individual: todo el contenido se descarta junto con el arena (o con reset()).
+// Solo admite tipos trivialmente destructibles.
+class Arena
+{
+public:
+    explicit Arena(std::size_t firstBlockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+
+    template <typename T>
+    T* allocateArray(std::size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena no ejecuta destructores");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Copia 'n' elementos al arena y devuelve la vista sobre la copia
+    template <typename T>
+    ArenaSpan<T> copyArray(const T* source, std::size_t n) {
+        if (n == 0) return {};
+        T* target = allocateArray<T>(n);
+        std::uninitialized_copy(source, source + n, target);
+        return { target, n };
+    }
+
+    // Descarta todo el contenido y conserva el bloque más grande para reutilizarlo
+    void reset();
+
+    std::size_t bytesReserved() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    void addBlock(std::size_t minBytes);
+
+    std::vector<Block> blocks;
+    std::size_t nextBlockSize;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+};
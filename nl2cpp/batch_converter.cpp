@@ -0,0 +1,155 @@
+﻿#include "stdafx.h"
+#include "batch_converter.h"
+#include "conversion_cache.h"
+#include "converter.h"
+#include "qt_adapter.h"
+#include "worker_pool.h"
+
+#include <QFile>
+#include <QThread>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Resultados indexados por posición de entrada; el hilo llamador los consume en orden
+class OrderedResults {
+public:
+    explicit OrderedResults(int count) : results(count), ready(count, false) {}
+
+    void publish(int index, BatchResult&& result) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results[index] = std::move(result);
+            ready[index] = true;
+        }
+        cond.notify_one();
+    }
+
+    BatchResult take(int index) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return ready[index]; });
+        return std::move(results[index]);
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<BatchResult> results;
+    std::vector<bool> ready;
+};
+
+// 'key' es la clave ya calculada en la primera pasada (nullptr si no se pudo leer entonces)
+BatchResult convertFile(const Converter& converter, const QString& path, const CacheKey* key)
+{
+    BatchResult result;
+    result.inputPath = path;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    // El archivo se lee proyectado en memoria, sin copiarlo a un QString
+    if (key) {
+        MappedLineReader reader(file);
+        result.output = QtAdapter::toQString(converter.convert(reader, *key));
+    }
+    else {
+        result.output = QtAdapter::convert(converter, file);
+    }
+    result.ok = true;
+    return result;
+}
+
+} // namespace
+
+// ==================== CONSTRUCTOR ====================
+BatchConverter::BatchConverter(int workerCount)
+    : workers(workerCount > 0 ? workerCount : qMax(1, QThread::idealThreadCount()))
+{
+}
+
+BatchConverter::~BatchConverter() {}
+
+// ==================== MÉTODO PRINCIPAL ====================
+
+void BatchConverter::run(const QStringList& inputPaths, const ResultCallback& onResult)
+{
+    const int total = int(inputPaths.size());
+    if (total == 0) return;
+
+    const int threadCount = qMin(workers, total);
+
+    // Un Converter compartido: cada conversión toma su propio espacio de trabajo
+    // y suma sus métricas al terminar, sin bloqueos durante la conversión
+    Converter converter;
+    converter.setCache(cache);
+    converter.setThreadCount(1);      // el paralelismo ya es por archivo
+    converter.setStats(stats);
+    const std::uint64_t fingerprint = converter.outputFingerprint();
+
+    std::vector<int> all(total);
+    for (int i = 0; i < total; ++i) all[i] = i;
+
+    // 1) Clave de cada entrada, leyendo línea a línea
+    std::vector<CacheKey> keys(total);
+    std::vector<char> hasKey(total, 0);
+    WorkerPool(all, threadCount, [&](int, int job) {
+        QFile file(inputPaths[job]);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;   // el error se informa al convertir
+        MappedLineReader reader(file);
+        keys[job] = OutputCache::keyFor(reader, fingerprint);
+        hasKey[job] = 1;
+    }).join();
+
+    // 2) Solo se convierte el primer archivo de cada clave; 'copies' cuenta sus repetidos
+    std::vector<int> owner(total);
+    std::vector<int> copies(total, 0);
+    std::vector<int> jobs;
+    jobs.reserve(total);
+    {
+        std::unordered_map<CacheKey, int, CacheKeyHash> first;
+        for (int i = 0; i < total; ++i) {
+            owner[i] = i;
+            if (hasKey[i]) {
+                const auto found = first.try_emplace(keys[i], i).first;
+                owner[i] = found->second;
+            }
+            if (owner[i] == i) jobs.push_back(i);
+            else ++copies[owner[i]];
+        }
+    }
+
+    OrderedResults results(total);
+    WorkerPool pool(jobs, threadCount, [&](int, int job) {
+        results.publish(job, convertFile(converter, inputPaths[job], hasKey[job] ? &keys[job] : nullptr));
+    });
+
+    // Escritor ordenado: entrega cada resultado apenas están listos todos los
+    // anteriores. El dueño de una clave siempre va antes que sus repetidos, así
+    // su resultado se guarda solo hasta entregar la última copia.
+    std::unordered_map<int, BatchResult> shared;
+    for (int i = 0; i < total; ++i) {
+        const int first = owner[i];
+        if (first == i) {
+            BatchResult result = results.take(i);
+            if (copies[i] > 0) shared.emplace(i, result);
+            onResult(result);
+            continue;
+        }
+
+        const auto found = shared.find(first);
+        BatchResult copy = found->second;      // QString compartido: no copia el texto
+        copy.inputPath = inputPaths[i];
+        copy.duplicate = true;
+        if (--copies[first] == 0) shared.erase(found);
+        onResult(copy);
+    }
+
+    pool.join();
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class ConversionCache;
+struct ConversionStats;
+
+// Resultado de convertir un archivo dentro de un lote
+struct BatchResult {
+    QString inputPath;
+    QString output;
+    bool ok = false;
+    QString error;
+    bool duplicate = false;     // misma entrada normalizada que un archivo anterior del lote
+};
+
+// Convierte muchos archivos en paralelo. Los hilos de trabajo comparten un
+// Converter y cada uno tiene su cola de trabajos; cuando se vacía roba trabajos
+// del final de las colas de otros hilos. Los resultados se entregan siempre en el orden de
+// entrada, así la salida es determinista sin importar el número de hilos.
+//
+// Antes de convertir se calcula la clave de caché de cada entrada (también en
+// paralelo): los archivos idénticos del lote se convierten una sola vez y los
+// repetidos reciben una copia del resultado del primero.
+class BatchConverter
+{
+public:
+    using ResultCallback = std::function<void(const BatchResult&)>;
+
+    // workerCount <= 0 usa QThread::idealThreadCount()
+    explicit BatchConverter(int workerCount = 0);
+    ~BatchConverter();
+
+    // Convierte 'inputPaths'. 'onResult' se invoca en el hilo llamador,
+    // una vez por archivo y en el mismo orden que 'inputPaths'.
+    void run(const QStringList& inputPaths, const ResultCallback& onResult);
+
+    int workerCount() const { return workers; }
+
+    // Caché persistente compartida por todos los hilos (nullptr = ninguna)
+    void setCache(ConversionCache* conversionCache) { cache = conversionCache; }
+
+    // Suma aquí las métricas de todos los hilos (nullptr = ninguna); completas al volver run()
+    void setStats(ConversionStats* conversionStats) { stats = conversionStats; }
+
+private:
+    int workers;
+    ConversionCache* cache = nullptr;
+    ConversionStats* stats = nullptr;
+};
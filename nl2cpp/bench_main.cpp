@@ -0,0 +1,302 @@
+﻿#include "stdafx.h"
+#include "converter.h"
+#include "corpus_generator.h"
+#include "line_reader.h"
+#include "lexer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+// ==================== CONTEO DE RESERVAS ====================
+// Con glibc se interceptan malloc/free (QString y QList reservan con malloc);
+// en otras plataformas solo se cuentan los operator new.
+
+namespace {
+std::atomic<std::uint64_t> allocationCount{ 0 };
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(std::size_t) noexcept;
+void* __libc_calloc(std::size_t, std::size_t) noexcept;
+void* __libc_realloc(void*, std::size_t) noexcept;
+void __libc_free(void*) noexcept;
+
+void* malloc(std::size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) noexcept
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) noexcept
+{
+    __libc_free(pointer);
+}
+}
+constexpr const char* allocationCounter = "malloc";
+#else
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+constexpr const char* allocationCounter = "operator new";
+#endif
+
+namespace {
+
+// ==================== MEDICIÓN ====================
+
+struct Measurement {
+    double seconds = 0;             // mejor tiempo de todas las repeticiones
+    std::uint64_t allocations = 0;  // reservas de la última repetición
+};
+
+// Repite 'body' y se queda con el mejor tiempo; la primera vuelta calienta
+// cachés y buffers reutilizables, por eso las reservas se cuentan en la última
+Measurement measure(int iterations, const std::function<void()>& body)
+{
+    Measurement m;
+    m.seconds = -1;
+    for (int i = 0; i < iterations; ++i) {
+        const std::uint64_t before = allocationCount.load(std::memory_order_relaxed);
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        const double seconds = double(timer.nsecsElapsed()) / 1e9;
+        m.allocations = allocationCount.load(std::memory_order_relaxed) - before;
+        if (m.seconds < 0 || seconds < m.seconds) m.seconds = seconds;
+    }
+    return m;
+}
+
+QJsonObject report(const Measurement& m, qint64 bytes, int lines)
+{
+    const double seconds = qMax(m.seconds, 1e-9);
+    QJsonObject o;
+    o["seconds"] = m.seconds;
+    o["bytesPerSecond"] = double(bytes) / seconds;
+    o["linesPerSecond"] = double(lines) / seconds;
+    o["allocationsPerLine"] = double(m.allocations) / qMax(lines, 1);
+    return o;
+}
+
+// Mide cada etapa por separado y la conversión completa sobre un programa de 'lines' líneas
+QJsonObject runSize(CorpusOptions options, int lines, int iterations)
+{
+    options.lines = lines;
+    // El núcleo trabaja en UTF-8: el texto se pasa una sola vez, fuera de la medición
+    const std::string text = CorpusGenerator::generate(options).toStdString();
+    const qint64 bytes = qint64(text.size());
+    const int lineCount = int(std::count(text.begin(), text.end(), '\n'));
+
+    // Normalización y tokenizado, línea a línea
+    LexedLine lexed;
+    std::string_view raw;
+    const Measurement lex = measure(iterations, [&] {
+        StringLineReader reader(text);
+        while (reader.readLine(raw)) Lexer::lex(raw, lexed);
+    });
+
+    // Parseo completo (incluye el lexer)
+    NaturalLanguageProcessor processor;
+    const Measurement parse = measure(iterations, [&] {
+        Program program = processor.processText(text);
+    });
+
+    // Generación sobre un programa ya parseado
+    const Program program = processor.processText(text);
+    CodeGenerator generator;
+    std::size_t outputSize = 0;
+    const Measurement generate = measure(iterations, [&] {
+        outputSize = generator.generateCode(program).size();
+    });
+
+    // De punta a punta
+    Converter converter;
+    const Measurement convert = measure(iterations, [&] {
+        converter.convert(text);
+    });
+
+    QJsonObject stages;
+    stages["lex"] = report(lex, bytes, lineCount);
+    stages["parse"] = report(parse, bytes, lineCount);
+    stages["generate"] = report(generate, bytes, lineCount);
+    stages["convert"] = report(convert, bytes, lineCount);
+
+    QJsonObject result;
+    result["lines"] = lineCount;
+    result["inputBytes"] = double(bytes);
+    result["outputBytes"] = double(outputSize);
+    result["stages"] = stages;
+    return result;
+}
+
+// 'repetir' con 'levels' bloques si/mientras alternados, uno dentro de otro
+std::string nestedProgram(int levels)
+{
+    std::string text = "comenzar programa\ncrear variable entero x\nrepetir\n";
+    for (int d = 0; d < levels; ++d) text += (d % 2) ? "mientras x menor que 10\n" : "si x mayor que 0\n";
+    text += "mostrar x\n";
+    for (int d = levels - 1; d >= 0; --d) text += (d % 2) ? "fin mientras\n" : "fin si\n";
+    text += "hasta que x igual a 0\nterminar programa\n";
+    return text;
+}
+
+// Parseo y análisis semántico de 'levels' y de 2 * 'levels' bloques anidados.
+// Los dos crecen linealmente, así que 'ratio' debería rondar 2; la generación
+// no se mide porque la sangría hace la salida cuadrática.
+QJsonObject runNesting(int levels, int iterations)
+{
+    NaturalLanguageProcessor processor;
+    CodeGenerator generator;
+    Program program;
+
+    QJsonObject result;
+    result["levels"] = levels;
+    double seconds[2] = {};
+    for (int i = 0; i < 2; ++i) {
+        const std::string text = nestedProgram(levels << i);
+        const Measurement m = measure(iterations, [&] {
+            StringLineReader reader(text);
+            processor.processLines(reader, program);
+            generator.beginProgram(program.names);
+            generator.analyze(program.instructions);
+            generator.resolveFunctions();
+            generator.endProgram();
+        });
+        seconds[i] = m.seconds;
+        result[i == 0 ? "single" : "double"] = report(m, qint64(text.size()), 2 * (levels << i) + 6);
+    }
+    result["ratio"] = seconds[1] / qMax(seconds[0], 1e-9);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("nl2cpp-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mide cada etapa del conversor sobre programas sinteticos y escribe JSON.");
+    parser.addHelpOption();
+
+    QCommandLineOption sizesOption("sizes", "Tamanos en lineas, separados por comas.", "n,n,...", "1000,5000,20000");
+    QCommandLineOption depthOption("depth", "Anidamiento maximo de bloques.", "n", "3");
+    QCommandLineOption functionsOption("functions", "Funciones definidas.", "n", "20");
+    QCommandLineOption stringsOption("strings", "Fraccion de 'mostrar' con literal (0..1).", "p", "0.3");
+    QCommandLineOption variablesOption("variables", "Variables declaradas.", "n", "20");
+    QCommandLineOption seedOption("seed", "Semilla del generador.", "n", "1");
+    QCommandLineOption iterationsOption("iterations", "Repeticiones por medicion (se toma la mejor).", "n", "5");
+    QCommandLineOption outputOption({ "o", "output" }, "Escribe el JSON en <archivo> en lugar de stdout.", "archivo");
+    QCommandLineOption corpusOption("corpus", "Solo escribe el programa generado (del primer tamano) y termina.");
+    QCommandLineOption nestingOption("nesting", "Niveles de anidamiento para medir el escalado del parseo (0 = no medir).", "n", "100000");
+    parser.addOptions({ sizesOption, depthOption, functionsOption, stringsOption, variablesOption,
+                        seedOption, iterationsOption, outputOption, corpusOption, nestingOption });
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    CorpusOptions options;
+    options.maxDepth = parser.value(depthOption).toInt();
+    options.functions = parser.value(functionsOption).toInt();
+    options.stringDensity = parser.value(stringsOption).toDouble();
+    options.variables = parser.value(variablesOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const int nesting = qMax(0, parser.value(nestingOption).toInt());
+
+    std::vector<int> sizes;
+    for (const QString& s : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int n = s.trimmed().toInt(&ok);
+        if (!ok || n <= 0) {
+            err << "nl2cpp-bench: tamano invalido: " << s << "\n";
+            return 1;
+        }
+        sizes.push_back(n);
+    }
+    if (sizes.empty()) {
+        err << "nl2cpp-bench: no hay tamanos\n";
+        return 1;
+    }
+
+    QByteArray output;
+    if (parser.isSet(corpusOption)) {
+        options.lines = sizes.front();
+        output = CorpusGenerator::generate(options).toUtf8();
+    }
+    else {
+        QJsonObject corpus;
+        corpus["maxDepth"] = options.maxDepth;
+        corpus["functions"] = options.functions;
+        corpus["stringDensity"] = options.stringDensity;
+        corpus["variables"] = options.variables;
+        corpus["seed"] = double(options.seed);
+
+        QJsonArray results;
+        for (int lines : sizes) {
+            err << "nl2cpp-bench: " << lines << " lineas...\n";
+            err.flush();
+            results.append(runSize(options, lines, iterations));
+        }
+
+        QJsonObject root;
+        root["generatorVersion"] = CodeGenerator::outputVersion;
+        root["qtVersion"] = QString::fromLatin1(qVersion());
+        root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        root["iterations"] = iterations;
+        root["allocationCounter"] = QString::fromLatin1(allocationCounter);
+        root["corpus"] = corpus;
+        root["results"] = results;
+        if (nesting > 0) {
+            err << "nl2cpp-bench: anidamiento de " << nesting << " niveles...\n";
+            err.flush();
+            root["nesting"] = runNesting(nesting, iterations);
+        }
+        output = QJsonDocument(root).toJson();
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(output) != output.size()) {
+            err << "nl2cpp-bench: " << file.fileName() << ": " << file.errorString() << "\n";
+            return 1;
+        }
+    }
+    else {
+        QTextStream(stdout) << QString::fromUtf8(output);
+    }
+    return 0;
+}
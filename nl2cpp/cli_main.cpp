@@ -0,0 +1,299 @@
+﻿#include "stdafx.h"
+#include "batch_converter.h"
+#include "conversion_cache.h"
+#include "conversion_stats.h"
+#include "project_converter.h"
+#include "qt_adapter.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Archivo a convertir y ruta relativa con la que se escribe su salida
+struct CliInput {
+    QString path;
+    QString relativeOutput;
+};
+
+QString toCppName(const QString& relativePath)
+{
+    const QFileInfo info(relativePath);
+    const QString dir = info.path();
+    const QString name = info.completeBaseName() + ".cpp";
+    return (dir == ".") ? name : dir + "/" + name;
+}
+
+// Expande archivos y directorios (recursivo, *.txt; el contenido de cada
+// directorio en orden alfabético). Un archivo que aparece más de una vez
+// (misma ruta canónica) se convierte una sola vez. Con 'writesFiles', dos
+// archivos distintos que escribirían el mismo .cpp son un error y se omite
+// el segundo.
+std::vector<CliInput> collectInputs(const QStringList& args, bool writesFiles, QTextStream& err, bool& ok)
+{
+    std::vector<CliInput> inputs;
+    QSet<QString> seen;
+    QHash<QString, QString> outputOwner;    // .cpp de salida -> entrada que lo escribe
+    ok = true;
+
+    auto add = [&](const QString& path, const QString& relativeOutput) {
+        const QString canonical = QFileInfo(path).canonicalFilePath();
+        if (seen.contains(canonical)) return;
+        seen.insert(canonical);
+        if (!writesFiles) {
+            inputs.push_back({ path, relativeOutput });
+            return;
+        }
+
+        const auto owner = outputOwner.constFind(relativeOutput);
+        if (owner != outputOwner.constEnd()) {
+            err << "nl2cpp-cli: " << *owner << " y " << path << " se escribirian en " << relativeOutput << "\n";
+            ok = false;
+            return;
+        }
+        outputOwner.insert(relativeOutput, path);
+        inputs.push_back({ path, relativeOutput });
+    };
+
+    for (const QString& arg : args) {
+        const QFileInfo info(arg);
+        if (info.isDir()) {
+            const QDir root(arg);
+            std::vector<CliInput> found;
+            QDirIterator it(arg, { "*.txt" }, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext()) {
+                const QString path = it.next();
+                found.push_back({ path, toCppName(root.relativeFilePath(path)) });
+            }
+            std::sort(found.begin(), found.end(),
+                [](const CliInput& a, const CliInput& b) { return a.path < b.path; });
+            for (const CliInput& in : found) add(in.path, in.relativeOutput);
+        }
+        else if (info.isFile()) {
+            add(arg, toCppName(info.fileName()));
+        }
+        else {
+            err << "nl2cpp-cli: no existe: " << arg << "\n";
+            ok = false;
+        }
+    }
+    return inputs;
+}
+
+// Texto UTF-8 de una entrada, sin BOM ni '\r' (como en la conversión por lotes)
+bool readSource(const QString& path, std::string& text, QString& error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    MappedLineReader reader(file);
+    std::string_view line;
+    text.clear();
+    while (reader.readLine(line)) {
+        text += line;
+        text += '\n';
+    }
+    return true;
+}
+
+bool writeCode(const QString& target, const std::string& code, QTextStream& err)
+{
+    QDir().mkpath(QFileInfo(target).path());
+    QFile file(target);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) ||
+        file.write(code.data(), qint64(code.size())) != qint64(code.size())) {
+        err << "nl2cpp-cli: " << target << ": " << file.errorString() << "\n";
+        return false;
+    }
+    return true;
+}
+
+// --project: las entradas forman un solo programa. Cada una se convierte en
+// un .cpp que incluye <nombre>.h, con los prototipos de todas las funciones.
+int convertProject(const std::vector<CliInput>& inputs, const QString& name, const QString& outputDir,
+                   int jobs, int failures, QTextStream& out, QTextStream& err)
+{
+    const QString headerName = name + ".h";
+    ProjectConverter project(headerName.toStdString());
+    project.setThreadCount(jobs);
+
+    // El proyecto identifica cada archivo por su ruta: una ruta repetida es
+    // una sola unidad, así que se recorren las unidades del proyecto
+    std::map<std::string, const CliInput*> inputByName;
+    std::string text;
+    for (const CliInput& in : inputs) {
+        QString error;
+        if (!readSource(in.path, text, error)) {
+            err << "nl2cpp-cli: " << in.path << ": " << error << "\n";
+            ++failures;
+            continue;
+        }
+        const std::string unitName = in.path.toStdString();
+        project.setSource(unitName, text);
+        inputByName[unitName] = &in;
+    }
+    project.update();
+
+    for (const std::string& error : project.linkErrors()) {
+        err << "nl2cpp-cli: enlace: " << QtAdapter::toQString(error) << "\n";
+        ++failures;
+    }
+
+    if (outputDir.isEmpty()) {
+        out << "// ==== " << headerName << "\n" << QtAdapter::toQString(project.headerCode());
+        for (std::size_t i = 0; i < project.unitCount(); ++i) {
+            out << "// ==== " << inputByName.at(project.unitName(i))->path << "\n" << QtAdapter::toQString(project.unitCode(i));
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    const QDir dir(outputDir);
+    if (!writeCode(dir.filePath(headerName), project.headerCode(), err)) ++failures;
+    for (std::size_t i = 0; i < project.unitCount(); ++i) {
+        const CliInput& in = *inputByName.at(project.unitName(i));
+        if (!writeCode(dir.filePath(in.relativeOutput), project.unitCode(i), err)) ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("nl2cpp-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Convierte pseudocodigo en lenguaje natural a C++.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("entradas", "Archivos .txt o directorios a convertir.", "<entradas...>");
+
+    QCommandLineOption outputDirOption({ "o", "output-dir" },
+        "Escribe un .cpp por entrada en <dir> en lugar de la salida estandar.", "dir");
+    QCommandLineOption jobsOption({ "j", "jobs" },
+        "Numero de hilos de trabajo (por defecto, los nucleos disponibles).", "n");
+    QCommandLineOption cacheOption("cache",
+        "Reutiliza conversiones guardadas en <dir> (compartible entre procesos).", "dir");
+    QCommandLineOption cacheSizeOption("cache-size",
+        "Tamano maximo de la cache en MB (por defecto 256).", "mb", "256");
+    parser.addOption(outputDirOption);
+    parser.addOption(jobsOption);
+    QCommandLineOption statsOption("stats",
+        "Escribe en la salida de errores los tiempos por etapa y las instrucciones por tipo.");
+    QCommandLineOption projectOption("project",
+        "Convierte las entradas como un solo programa: un .cpp por entrada y la cabecera "
+        "<nombre>.h con los prototipos de todas las funciones (sin --cache ni --stats).", "nombre");
+    parser.addOption(cacheOption);
+    parser.addOption(cacheSizeOption);
+    parser.addOption(statsOption);
+    parser.addOption(projectOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    // La conversión de proyectos no pasa por BatchConverter: ni cache ni métricas
+    if (parser.isSet(projectOption) && (parser.isSet(cacheOption) || parser.isSet(statsOption))) {
+        err << "nl2cpp-cli: --project no admite --cache ni --stats\n";
+        return 1;
+    }
+
+    bool inputsOk = true;
+    const std::vector<CliInput> inputs = collectInputs(parser.positionalArguments(),
+        parser.isSet(outputDirOption), err, inputsOk);
+    if (inputs.empty()) {
+        if (inputsOk) err << "nl2cpp-cli: no hay archivos de entrada\n";
+        return 1;
+    }
+
+    int jobs = 0;
+    if (parser.isSet(jobsOption)) {
+        bool ok = false;
+        jobs = parser.value(jobsOption).toInt(&ok);
+        if (!ok || jobs <= 0) {
+            err << "nl2cpp-cli: valor invalido para --jobs\n";
+            return 1;
+        }
+    }
+
+    std::unique_ptr<ConversionCache> cache;
+    if (parser.isSet(cacheOption)) {
+        bool ok = false;
+        const qint64 megabytes = parser.value(cacheSizeOption).toLongLong(&ok);
+        if (!ok || megabytes <= 0) {
+            err << "nl2cpp-cli: valor invalido para --cache-size\n";
+            return 1;
+        }
+        cache = std::make_unique<ConversionCache>(parser.value(cacheOption), megabytes * 1024 * 1024);
+    }
+
+    const QString outputDir = parser.value(outputDirOption);
+    if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+        err << "nl2cpp-cli: no se pudo crear " << outputDir << "\n";
+        return 1;
+    }
+
+    if (parser.isSet(projectOption)) {
+        return convertProject(inputs, parser.value(projectOption), outputDir, jobs, inputsOk ? 0 : 1, out, err);
+    }
+
+    QStringList paths;
+    paths.reserve(qsizetype(inputs.size()));
+    for (const auto& in : inputs) paths << in.path;
+
+    int failures = inputsOk ? 0 : 1;
+    int index = 0;
+    int duplicates = 0;
+    ConversionStats stats;
+
+    BatchConverter batch(jobs);
+    batch.setCache(cache.get());
+    if (parser.isSet(statsOption)) batch.setStats(&stats);
+    batch.run(paths, [&](const BatchResult& result) {
+        const CliInput& in = inputs[index++];
+
+        if (!result.ok) {
+            err << "nl2cpp-cli: " << result.inputPath << ": " << result.error << "\n";
+            ++failures;
+            return;
+        }
+        if (result.duplicate) ++duplicates;
+
+        // Sin directorio de salida: todo a stdout, con cabecera si hay varias entradas
+        if (outputDir.isEmpty()) {
+            if (inputs.size() > 1) out << "// ==== " << in.path << "\n";
+            out << result.output;
+            return;
+        }
+
+        const QString target = QDir(outputDir).filePath(in.relativeOutput);
+        if (!writeCode(target, result.output.toStdString(), err)) ++failures;
+    });
+
+    if (cache) {
+        err << "nl2cpp-cli: cache: " << cache->hits() << " aciertos, " << cache->misses()
+            << " fallos, " << duplicates << " repetidos en el lote\n";
+    }
+
+    if (parser.isSet(statsOption)) {
+        err << QString::fromStdString(stats.report()) << "\n";
+    }
+
+    out.flush();
+    err.flush();
+    return failures == 0 ? 0 : 1;
+}
@@ -1,7 +1,16 @@
 ﻿#include "stdafx.h"
 #include "code_generator.h"
-#include <QTextStream>
-#include <QRegularExpression>
+#include "conversion_stats.h"
+#include "emit_template.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+
+namespace {
+// Con menos definiciones no compensa arrancar hilos
+constexpr std::size_t minParallelDefinitions = 32;
+}
 
 // ==================== CONSTRUCTOR ====================
 CodeGenerator::CodeGenerator() {}
@@ -12,410 +21,765 @@ void CodeGenerator::resetState() {
     needsResultado = false;
     insideMain = false;
     symbols.clear();
-    functionParamTypes.clear();
-    functionParamNames.clear();
+    functionUses.clear();
+    usePool.clear();
+    useMark.clear();
+    functionParams.clear();
+    paramPool.clear();
     lastArrayName = "lista";
     lastArraySize = 0;
+    symbolsHash = 0;
+    paramsHash = 0;
 }
 
 // ==================== MÉTODO PRINCIPAL ====================
-QString CodeGenerator::generateCode(const std::vector<Instruction>& instructions)
+std::string CodeGenerator::generateCode(const Program& program)
 {
-    resetState();
+    std::string code;
+    StringSink sink(code, estimateSize(program));
+    generateCode(program, sink);
+    return code;
+}
+
+// El código C++ ocupa aproximadamente el doble que las líneas normalizadas
+std::size_t CodeGenerator::estimateSize(const Program& program)
+{
+    return program.textLength * 2 + 256;
+}
 
-    // 1) Colectar símbolos declarados (para firmas de funciones y llamadas)
-    collectSymbols(instructions);
+void CodeGenerator::generateCode(const Program& program, CodeSink& out)
+{
+    const InstructionList instructions = program.instructions;
+    beginProgram(program.names);
+    const std::int64_t start = stats ? ConversionStats::now() : 0;
 
-    QString code;
-    QTextStream out(&code);
+    // 1) Análisis: un solo recorrido del árbol; el resto solo lee el modelo
+    analyze(instructions);
+    resolveFunctions();
+    const std::int64_t declared = stats ? ConversionStats::now() : 0;
 
     // 2) Includes básicos
+    writePrologue(out);
+
+    // 3) Definiciones de funciones ANTES de main
+    writeFunctionDefinitions(instructions, out);
+
+    // 4) main(), con 'resultado' si habrá aritmética
+    writeMainOpen(out);
+
+    // 5) Cuerpo (ignorando ProgramStart/End y FunctionDefinition)
+    writeStatements(instructions, out);
+
+    // 6) Cerrar main
+    writeEpilogue(out);
+
+    if (stats) {
+        stats->symbolsNs += declared - start;
+        stats->generateNs += ConversionStats::now() - declared;
+    }
+    endProgram();
+}
+
+// ==================== PASOS DE LA GENERACIÓN ====================
+
+void CodeGenerator::beginProgram(const Interner& programNames)
+{
+    resetState();
+    names = &programNames;
+}
+
+void CodeGenerator::endProgram()
+{
+    names = nullptr;
+}
+
+void CodeGenerator::analyze(InstructionList instructions, FragmentEffects* effects)
+{
+    openJournal(effects);
+    analyzeBlock(instructions);
+    closeJournal();
+}
+
+void CodeGenerator::resolveFunctions()
+{
+    for (const FunctionUses& uses : functionUses) {
+        paramScratch.clear();
+        for (std::uint32_t i = 0; i < uses.count; ++i) {
+            const SymbolId id = usePool[uses.begin + i];
+            if (symbols.contains(id)) paramScratch.push_back(id);
+        }
+
+        // Orden alfabético: la firma no depende del orden de aparición
+        std::sort(paramScratch.begin(), paramScratch.end(), [this](SymbolId a, SymbolId b) {
+            return names->text(a) < names->text(b);
+        });
+
+        setFunctionParams(uses.function, paramScratch.data(), paramScratch.size());
+    }
+}
+
+void CodeGenerator::writePrologue(CodeSink& out)
+{
     out << "#include <iostream>\n";
     if (needsStringHeader) out << "#include <string>\n";
     out << "using namespace std;\n\n";
+}
 
-    // 3) Definiciones de funciones ANTES de main
+void CodeGenerator::writeFunctionDefinitions(InstructionList instructions, CodeSink& out, FragmentEffects* effects)
+{
+    openJournal(effects);
+    definitionList.clear();
     for (const auto& inst : instructions) {
-        if (inst.type == InstructionType::FunctionDefinition) {
-            out << generateFunctionDefinition(inst) << "\n";
+        if (inst.type == InstructionType::FunctionDefinition) definitionList.push_back(&inst);
+    }
+
+    const int threads = threadCount > 0 ? threadCount : WorkerPool::idealThreadCount();
+    if (threads > 1 && definitionList.size() >= minParallelDefinitions) {
+        writeDefinitionsParallel(threads, out);
+    }
+    else {
+        for (const Instruction* definition : definitionList) {
+            if (cancelled()) break;
+            generateFunctionDefinition(*definition, out);
+            out << "\n";
         }
     }
+    closeJournal();
+}
 
-    // 4) main()
+// Cada hilo genera funciones con su propia copia del generador: el modelo
+// semántico es de solo lectura. Lo único que una función hereda de las
+// anteriores es el último arreglo ("recorrer la lista"); se genera suponiendo
+// el de entrada y, si la función lo leyó y al coser en orden resulta otro, se
+// regenera en serie. La salida es la misma que la de la generación en serie.
+void CodeGenerator::writeDefinitionsParallel(int threads, CodeSink& out)
+{
+    struct Generated {
+        std::string code;
+        bool createdArray = false;
+        bool readInherited = false;
+        std::string arrayName;
+        int arraySize = 0;
+        std::int64_t errors = 0;
+    };
+
+    const int total = int(definitionList.size());
+    std::vector<Generated> generated(total);
+    const std::string entryName = lastArrayName;
+    const int entrySize = lastArraySize;
+
+    threads = std::min(threads, total);
+    std::vector<CodeGenerator> workers(threads, *this);
+    std::vector<ConversionStats> workerStats(threads);
+    for (int w = 0; w < threads; ++w) {
+        workers[w].journal = nullptr;
+        workers[w].stats = &workerStats[w];
+    }
+
+    std::vector<int> jobs(total);
+    std::iota(jobs.begin(), jobs.end(), 0);
+    WorkerPool(jobs, threads, [&](int w, int job) {
+        CodeGenerator& worker = workers[w];
+        Generated& result = generated[job];
+        worker.lastArrayName = entryName;
+        worker.lastArraySize = entrySize;
+        worker.arrayCreated = false;
+        worker.inheritedArrayRead = false;
+        const std::int64_t errorsBefore = workerStats[w].errorEmissions;
+
+        StringSink sink(result.code);
+        worker.generateFunctionDefinition(*definitionList[job], sink);
+        sink << "\n";
+
+        result.createdArray = worker.arrayCreated;
+        result.readInherited = worker.inheritedArrayRead;
+        result.arrayName = worker.lastArrayName;
+        result.arraySize = worker.lastArraySize;
+        result.errors = workerStats[w].errorEmissions - errorsBefore;
+    }).join();
+
+    // Costura en orden de aparición
+    for (int i = 0; i < total; ++i) {
+        if (cancelled()) break;
+        const Generated& result = generated[i];
+        if (result.readInherited && (lastArrayName != entryName || lastArraySize != entrySize)) {
+            generateFunctionDefinition(*definitionList[i], out);
+            out << "\n";
+            continue;
+        }
+        out << result.code;
+        if (stats) stats->errorEmissions += result.errors;
+        if (result.readInherited && !arrayCreated) inheritedArrayRead = true;
+        if (result.createdArray) {
+            lastArrayName = result.arrayName;
+            lastArraySize = result.arraySize;
+            arrayCreated = true;
+        }
+    }
+}
+
+void CodeGenerator::writeMainOpen(CodeSink& out)
+{
     out << "int main() {\n";
     insideMain = true;
 
-    // 5) 'resultado' si habrá aritmética
-    for (const auto& inst : instructions) {
-        if (inst.type == InstructionType::Arithmetic) { needsResultado = true; break; }
-        for (const auto& nin : inst.nested)
-            if (nin.type == InstructionType::Arithmetic) { needsResultado = true; break; }
-        if (needsResultado) break;
-    }
     if (needsResultado) {
         out << "    int resultado;\n";
     }
+}
 
-    // 6) Cuerpo (ignorando ProgramStart/End y FunctionDefinition)
-    for (const auto& inst : instructions) {
-        if (inst.type == InstructionType::FunctionDefinition ||
-            inst.type == InstructionType::ProgramStart ||
-            inst.type == InstructionType::ProgramEnd) {
-            continue;
-        }
+void CodeGenerator::writeStatements(InstructionList instructions, CodeSink& out, FragmentEffects* effects)
+{
+    openJournal(effects);
+    generateBlock(instructions, 1, true, out);
+    closeJournal();
+}
 
-        QString line;
-        switch (inst.type) {
-        case InstructionType::Arithmetic:
-            line = generateArithmetic(inst, 1);
-            break;
-        case InstructionType::VariableDeclaration:
-            line = generateVariableDeclaration(inst, 1);
-            break;
-        case InstructionType::Assignment:
-            line = generateAssignment(inst, 1);
-            break;
-        case InstructionType::ArrayCreation:
-            line = generateArrayCreation(inst, 1);
-            break;
-        case InstructionType::ControlStructure:
-            line = generateControlStructure(inst, 1);
-            break;
-        case InstructionType::Input:
-            line = generateInput(inst, 1);
-            break;
-        case InstructionType::Output:
-            line = generateOutput(inst, 1);
-            break;
-        case InstructionType::FunctionCall:
-            line = generateFunctionCall(inst, 1);
-            break;
-        default:
-            line = "    // [WARN] Unknown instruction: " + inst.keyword + "\n";
-            break;
-        }
+void CodeGenerator::writeEpilogue(CodeSink& out)
+{
+    out << "    return 0;\n";
+    out << "}\n";
+}
+
+// ==================== ESTADO GLOBAL Y FRAGMENTOS ====================
+
+namespace {
+// splitmix64: dispersa bien claves pequeñas y consecutivas
+std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+}
 
-        out << line;
-        if (!line.endsWith('\n')) out << "\n";
+void CodeGenerator::setSymbol(SymbolId id, CppType type)
+{
+    if (const CppType* old = symbols.find(id)) {
+        symbolsHash -= mix((std::uint64_t(id) << 8) | std::uint8_t(*old));
     }
+    symbols[id] = type;
+    symbolsHash += mix((std::uint64_t(id) << 8) | std::uint8_t(type));
 
-    // 7) Cerrar main
-    out << "    return 0;\n";
-    out << "}\n";
+    if (journal) journal->symbols.push_back({ id, type });
+}
 
-    return code;
+void CodeGenerator::setFunctionParams(SymbolId funcId, const SymbolId* params, std::size_t count)
+{
+    ParamRange& range = functionParams[funcId];
+    paramsHash -= range.hash;
+
+    range.begin = std::uint32_t(paramPool.size());
+    range.count = std::uint32_t(count);
+    range.hash = mix(funcId);
+    for (std::size_t i = 0; i < count; ++i) {
+        paramPool.push_back(params[i]);
+        range.hash = mix(range.hash ^ params[i]);
+    }
+    paramsHash += range.hash;
 }
 
-// ==================== PRE-SCAN SÍMBOLOS ====================
-void CodeGenerator::collectSymbols(const std::vector<Instruction>& instructions)
+void CodeGenerator::addFunctionUses(SymbolId funcId, const SymbolId* uses, std::size_t count)
 {
-    auto collectOne = [&](const Instruction& ins) {
-        if (ins.type == InstructionType::VariableDeclaration) {
-            QString type = "int";
-            if (ins.arguments.contains("decimal")) { type = "float"; }
-            else if (ins.arguments.contains("texto") || ins.arguments.contains("string")
-                || ins.arguments.contains("palabra") || ins.arguments.contains("cadena")) {
-                type = "string"; needsStringHeader = true;
-            }
-            else if (ins.arguments.contains("caracter")) { type = "char"; }
-            else if (ins.arguments.contains("booleano")) { type = "bool"; }
+    FunctionUses entry;
+    entry.function = funcId;
+    entry.begin = std::uint32_t(usePool.size());
+    entry.count = std::uint32_t(count);
+    usePool.insert(usePool.end(), uses, uses + count);
+    functionUses.push_back(entry);
+}
 
-            if (!ins.arguments.isEmpty()) {
-                QString name = ins.arguments.last();
-                symbols[name] = type;
-            }
+void CodeGenerator::requireString()
+{
+    needsStringHeader = true;
+    if (journal) journal->needsString = true;
+}
+
+void CodeGenerator::requireResultado()
+{
+    needsResultado = true;
+    if (journal) journal->needsResultado = true;
+}
+
+void CodeGenerator::openJournal(FragmentEffects* effects)
+{
+    journal = effects;
+    if (journal) journal->clear();
+    arrayCreated = false;
+    inheritedArrayRead = false;
+}
+
+void CodeGenerator::closeJournal()
+{
+    if (journal) {
+        journal->lastArrayName = lastArrayName;
+        journal->lastArraySize = lastArraySize;
+        journal->readsArray = inheritedArrayRead;
+        journal->createsArray = arrayCreated;
+    }
+    journal = nullptr;
+}
+
+void CodeGenerator::replay(const FragmentEffects& effects)
+{
+    for (const auto& write : effects.symbols) setSymbol(write.first, write.second);
+    for (const auto& uses : effects.functionUses) {
+        addFunctionUses(uses.first, uses.second.data(), uses.second.size());
+    }
+    if (effects.needsString) needsStringHeader = true;
+    if (effects.needsResultado) needsResultado = true;
+    lastArrayName = effects.lastArrayName;
+    lastArraySize = effects.lastArraySize;
+}
+
+CodeGenerator::FragmentState CodeGenerator::fragmentState(bool readsSymbols) const
+{
+    FragmentState state;
+    state.symbolsHash = readsSymbols ? symbolsHash : 0;
+    state.paramsHash = paramsHash;
+    state.lastArrayName = lastArrayName;
+    state.lastArraySize = lastArraySize;
+    return state;
+}
+
+void CodeGenerator::FragmentEffects::clear()
+{
+    symbols.clear();
+    functionUses.clear();
+    needsString = false;
+    needsResultado = false;
+    readsArray = false;
+    createsArray = false;
+}
+
+// Comentario de error en la salida; cuenta para las métricas
+void CodeGenerator::writeError(CodeSink& out, const char* message)
+{
+    if (stats) ++stats->errorEmissions;
+    out << "// Error: " << message;
+}
+
+std::string_view CodeGenerator::typeName(CppType type)
+{
+    switch (type) {
+    case CppType::Float:  return "float";
+    case CppType::String: return "string";
+    case CppType::Char:   return "char";
+    case CppType::Bool:   return "bool";
+    default:              return "int";
+    }
+}
+
+// ==================== PLANTILLAS DE EMISIÓN ====================
+
+namespace {
+// Cada construcción se descompone durante la compilación; generar solo rellena los huecos
+constexpr EmitTemplate ifOpen("if ({0}) {\n");
+constexpr EmitTemplate elseOpen("else {\n");
+constexpr EmitTemplate whileOpen("while ({0}) {\n");
+constexpr EmitTemplate forOpen("for (int {0} = {1}; {0} <= {2}; {0}++) {\n");
+constexpr EmitTemplate doOpen("do {\n");
+constexpr EmitTemplate doClose("while ({0});");
+constexpr EmitTemplate blockClose("}");
+constexpr EmitTemplate declaration("{0} {1};");
+constexpr EmitTemplate arrayDeclaration("{0} {1}[{2}];");
+constexpr EmitTemplate assignment("{0} = {1};");
+constexpr EmitTemplate input("cin >> {0};");
+constexpr EmitTemplate output("cout << {0} << endl;");
+constexpr EmitTemplate traverseOpen("for (int i = 0; i < {0}; i++) {\n");
+constexpr EmitTemplate traverseBody("cout << {0} << \" \" << {1}[i] << endl;\n");
+constexpr EmitTemplate signatureOpen("void {0}(");
+constexpr EmitTemplate parameter("{0} {1}");
+constexpr EmitTemplate signatureClose(") {\n");
+constexpr EmitTemplate prototypeClose(");\n");
+constexpr EmitTemplate callOpen("{0}(");
+constexpr EmitTemplate callClose(");");
+}
+
+namespace {
+// Entero de un token Integer ([+-]dígitos); false si no cabe en un int
+bool parseInt(std::string_view text, int& value)
+{
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    const char* end = text.data() + text.size();
+    const auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// Palabras de tipo de "crear variable <tipo> x" y "crear lista de <tipo>s ...".
+// Cada construcción acepta las suyas: las declaraciones no toman plurales
+// (salvo "enteros"), y los arreglos no tienen entero explícito ni booleanos.
+struct TypeWord {
+    std::string_view word;
+    CodeGenerator::CppType type;
+    bool declaration;
+    bool array;
+};
+
+const TypeWord typeWords[] = {
+    { "entero",     CodeGenerator::CppType::Int,    true,  false },
+    { "enteros",    CodeGenerator::CppType::Int,    true,  false },
+    { "decimal",    CodeGenerator::CppType::Float,  true,  true  },
+    { "decimales",  CodeGenerator::CppType::Float,  false, true  },
+    { "texto",      CodeGenerator::CppType::String, true,  true  },
+    { "string",     CodeGenerator::CppType::String, true,  true  },
+    { "palabra",    CodeGenerator::CppType::String, true,  true  },
+    { "cadena",     CodeGenerator::CppType::String, true,  true  },
+    { "caracter",   CodeGenerator::CppType::Char,   true,  true  },
+    { "caracteres", CodeGenerator::CppType::Char,   false, true  },
+    { "booleano",   CodeGenerator::CppType::Bool,   true,  false },
+};
+}
+
+// Tipo de una declaración o de un arreglo, en una sola pasada por las palabras.
+// Si aparecen varias manda la primera de: entero, decimal, texto, caracter,
+// booleano (el orden de CppType); sin ninguna, int.
+CodeGenerator::CppType CodeGenerator::deduceType(const Instruction& ins)
+{
+    const bool array = ins.type == InstructionType::ArrayCreation;
+    CppType best = CppType::Int;
+    bool found = false;
+    for (std::ptrdiff_t i = 0; i < ins.argCount(); ++i) {
+        if (ins.tokens[i].kind != TokenKind::Keyword) continue;
+        const std::string_view tok = ins.arg(i);
+        for (const TypeWord& entry : typeWords) {
+            if (tok != entry.word) continue;
+            if (!(array ? entry.array : entry.declaration)) break;
+            if (!found || entry.type < best) best = entry.type;
+            found = true;
+            break;
         }
-        if (!ins.nested.empty()) {
-            collectSymbolsFromBlock(ins.nested);
+    }
+    return best;
+}
+
+// ==================== ANÁLISIS SEMÁNTICO ====================
+void CodeGenerator::analyzeBlock(InstructionList instructions)
+{
+    analysisLevels.clear();
+    analysisLevels.push_back({ instructions.begin(), instructions.end(), -1, false });
+
+    while (!analysisLevels.empty()) {
+        AnalysisLevel& level = analysisLevels.back();
+        if (level.next == level.end) {
+            if (level.definition && journal) {
+                const FunctionUses& done = functionUses[level.function];
+                const auto first = usePool.begin() + done.begin;
+                journal->functionUses.push_back({ done.function, std::vector<SymbolId>(first, first + done.count) });
+            }
+            analysisLevels.pop_back();
+            continue;
         }
-        };
 
-    for (const auto& ins : instructions) collectOne(ins);
+        const Instruction& ins = *level.next++;
+        const int function = level.function;
+        analyzeInstruction(ins, function < 0 ? nullptr : &functionUses[function]);
+
+        if (ins.type == InstructionType::FunctionDefinition && function < 0) {
+            // Definición de nivel superior: lo que usa su cuerpo decide la firma
+            FunctionUses uses;
+            uses.function = functionName(ins, nullptr);
+            uses.begin = std::uint32_t(usePool.size());
+            functionUses.push_back(uses);
+            analysisLevels.push_back({ ins.nested.begin(), ins.nested.end(), int(functionUses.size()) - 1, true });
+        }
+        else if (!ins.nested.empty()) {
+            analysisLevels.push_back({ ins.nested.begin(), ins.nested.end(), function, false });
+        }
+    }
 }
 
-void CodeGenerator::collectSymbolsFromBlock(const std::vector<Instruction>& nested)
+void CodeGenerator::analyzeInstruction(const Instruction& ins, FunctionUses* function)
 {
-    for (const auto& ins : nested) {
-        if (ins.type == InstructionType::VariableDeclaration) {
-            QString type = "int";
-            if (ins.arguments.contains("decimal")) { type = "float"; }
-            else if (ins.arguments.contains("texto") || ins.arguments.contains("string")
-                || ins.arguments.contains("palabra") || ins.arguments.contains("cadena")) {
-                type = "string"; needsStringHeader = true;
-            }
-            else if (ins.arguments.contains("caracter")) { type = "char"; }
-            else if (ins.arguments.contains("booleano")) { type = "bool"; }
+    switch (ins.type) {
+    case InstructionType::VariableDeclaration: {
+        const CppType type = deduceType(ins);
+        if (type == CppType::String) requireString();
+        if (!ins.tokens.empty()) setSymbol(ins.argSymbol(ins.argCount() - 1), type);
+        break;
+    }
+    case InstructionType::ArrayCreation:
+        if (!ins.hasArg("recorrer") && deduceType(ins) == CppType::String) requireString();
+        break;
+    case InstructionType::Arithmetic:
+        requireResultado();
+        break;
+    default:
+        break;
+    }
+
+    if (function) {
+        // Palabras del cuerpo, sin repetir dentro de la misma definición
+        const std::uint32_t mark = std::uint32_t(functionUses.size());
+        for (std::ptrdiff_t i = 0; i < ins.argCount(); ++i) {
+            const SymbolId id = ins.argSymbol(i);
+            if (id == NoSymbol) continue;
+            std::uint32_t& seen = useMark[id];
+            if (seen == mark) continue;
+            seen = mark;
+            usePool.push_back(id);
+            ++function->count;
+        }
+    }
+}
 
-            if (!ins.arguments.isEmpty()) {
-                QString name = ins.arguments.last();
-                symbols[name] = type;
-            }
+// Nombre de "definir funcion f" / "llamar funcion f" (por defecto 'funcion')
+SymbolId CodeGenerator::functionName(const Instruction& instruction, std::string_view* text) const
+{
+    for (int i = 0; i < instruction.argCount(); ++i) {
+        if (instruction.arg(i) == "funcion" && i + 1 < instruction.argCount()) {
+            if (text) *text = instruction.arg(i + 1);
+            return instruction.argSymbol(i + 1);
         }
-        if (!ins.nested.empty()) collectSymbolsFromBlock(ins.nested);
     }
+    if (text) *text = "funcion";
+    return names->find("funcion");
 }
 
 // ==================== AUXILIARES ====================
 
 // Aritmética: admite variables y números. Reutiliza 'resultado'.
-QString CodeGenerator::generateArithmetic(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateArithmetic(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString op = "+";
-    if (instruction.keyword.contains("restar")) op = "-";
-    else if (instruction.keyword.contains("multiplicar")) op = "*";
-    else if (instruction.keyword.contains("dividir")) op = "/";
-
-    QStringList tokens;
-    for (int i = 1; i < instruction.arguments.size(); ++i) {
-        const QString tok = instruction.arguments[i];
-        if (tok == "y" || tok == "e" || tok == "con") continue;
-        tokens << tok;
-    }
+    const char* op = " + ";
+    if (instruction.phrase == Phrase::Restar) op = " - ";
+    else if (instruction.phrase == Phrase::Multiplicar) op = " * ";
+    else if (instruction.phrase == Phrase::Dividir) op = " / ";
+
+    // Términos válidos: variables o números, sin los conectores
+    auto isTerm = [&instruction](std::ptrdiff_t i) {
+        const std::string_view tok = instruction.arg(i);
+        if (tok == "y" || tok == "e" || tok == "con") return false;
+        return instruction.tokens[i].isWord() || instruction.tokens[i].isNumber();
+    };
 
-    QStringList terms;
-    for (const auto& t : tokens) {
-        if (isIdentifier(t) || isNumber(t)) terms << t;
+    int termCount = 0;
+    for (std::ptrdiff_t i = 1; i < instruction.argCount() && termCount < 2; ++i) {
+        if (isTerm(i)) ++termCount;
     }
 
-    QString indent(indentLevel * 4, ' ');
-    if (terms.size() >= 2) {
-        QString expr;
-        for (int i = 0; i < terms.size(); ++i) {
-            if (i) expr += " " + op + " ";
-            expr += terms[i];
+    out.indent(indentLevel);
+    if (termCount >= 2) {
+        out << "resultado = ";
+        bool first = true;
+        for (std::ptrdiff_t i = 1; i < instruction.argCount(); ++i) {
+            if (!isTerm(i)) continue;
+            if (!first) out << op;
+            out << instruction.arg(i);
+            first = false;
         }
-        return indent + "resultado = " + expr + ";";
+        out << ";";
+        return;
     }
-    return indent + "// Error: invalid arithmetic instruction";
+    writeError(out, "invalid arithmetic instruction");
 }
 
 // Declaración de variable: "crear variable entero x"
-QString CodeGenerator::generateVariableDeclaration(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateVariableDeclaration(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString type = "int";
-    QString varName = "var";
-
-    if (instruction.arguments.contains("entero") || instruction.arguments.contains("enteros")) type = "int";
-    else if (instruction.arguments.contains("decimal")) type = "float";
-    else if (instruction.arguments.contains("texto") || instruction.arguments.contains("string")
-        || instruction.arguments.contains("palabra") || instruction.arguments.contains("cadena")) {
-        type = "string"; needsStringHeader = true;
-    }
-    else if (instruction.arguments.contains("caracter")) type = "char";
-    else if (instruction.arguments.contains("booleano")) type = "bool";
-
-    if (!instruction.arguments.isEmpty()) varName = instruction.arguments.last();
+    const std::string_view varName = instruction.tokens.empty() ? std::string_view("var") : instruction.lastArg();
 
-    symbols[varName] = type;
-    QString indent(indentLevel * 4, ' ');
-    return indent + type + " " + varName + ";";
+    out.indent(indentLevel);
+    declaration.emit(out, { typeName(deduceType(instruction)), varName });
 }
 
 // Asignación robusta (soporta "asignar valor x = 10" y "asignar x 10")
-QString CodeGenerator::generateAssignment(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateAssignment(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
+    out.indent(indentLevel);
 
     // Encuentra primer identificador tras "asignar" (saltando "valor")
     int firstId = -1;
-    for (int i = 0; i < instruction.arguments.size(); ++i) {
-        const QString& t = instruction.arguments[i];
+    for (int i = 0; i < instruction.argCount(); ++i) {
+        const std::string_view t = instruction.arg(i);
         if (t == "asignar" || t == "valor") continue;
-        if (isIdentifier(t)) { firstId = i; break; }
+        if (instruction.tokens[i].isWord()) { firstId = i; break; }
     }
     // Busca '='
-    int eqIndex = instruction.arguments.indexOf("=");
+    int eqIndex = instruction.indexOfArg("=");
 
-    if (firstId != -1 && eqIndex != -1 && eqIndex + 1 < instruction.arguments.size()) {
-        QString varName = instruction.arguments[firstId];
-        QString value = instruction.arguments.mid(eqIndex + 1).join(" ");
-        return indent + varName + " = " + value + ";";
+    if (firstId != -1 && eqIndex != -1 && eqIndex + 1 < instruction.argCount()) {
+        assignment.emit(out, { instruction.arg(firstId), instruction.argsFrom(eqIndex + 1) });
+        return;
     }
 
     // Sin '=': tomar todo lo que sigue al identificador como valor
-    if (firstId != -1 && firstId + 1 < instruction.arguments.size()) {
-        QString varName = instruction.arguments[firstId];
-        QString value = instruction.arguments.mid(firstId + 1).join(" ");
-        return indent + varName + " = " + value + ";";
+    if (firstId != -1 && firstId + 1 < instruction.argCount()) {
+        assignment.emit(out, { instruction.arg(firstId), instruction.argsFrom(firstId + 1) });
+        return;
     }
 
-    return indent + "// Error: invalid assignment";
+    writeError(out, "invalid assignment");
 }
 
 // Creación de arreglo o "recorrer la lista ..."
-QString CodeGenerator::generateArrayCreation(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateArrayCreation(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
-
     // Si viene mal tipado desde NLP para "recorrer la lista ..."
-    if (instruction.arguments.contains("recorrer")) {
-        int n = (lastArraySize > 0 ? lastArraySize : 5);
-        QString arr = lastArrayName;
+    if (instruction.hasArg("recorrer")) {
+        if (!arrayCreated) inheritedArrayRead = true;
+        const NumberText n(lastArraySize > 0 ? lastArraySize : 5);
 
         // Buscar literal entre comillas para el mensaje
-        QString msg;
+        scratch.resize(0);
         bool inQuotes = false;
-        for (const auto& tok : instruction.arguments) {
-            if (tok.startsWith("\"")) { inQuotes = true; msg += tok; }
-            else if (inQuotes) { msg += " " + tok; }
-            if (tok.endsWith("\"")) { inQuotes = false; break; }
+        for (std::ptrdiff_t i = 0; i < instruction.argCount(); ++i) {
+            const std::string_view tok = instruction.arg(i);
+            if (tok.front() == '"') { inQuotes = true; scratch += tok; }
+            else if (inQuotes) { scratch += ' '; scratch += tok; }
+            if (tok.back() == '"') { inQuotes = false; break; }
         }
-        if (msg.isEmpty()) msg = "\"Elemento:\"";
+        const std::string_view msg = scratch.empty() ? std::string_view("\"Elemento:\"") : std::string_view(scratch);
 
-        QString code;
-        code += indent + "for (int i = 0; i < " + QString::number(n) + "; i++) {\n";
-        code += indent + "    cout << " + msg + " << \" \" << " + arr + "[i] << endl;\n";
-        code += indent + "}";
-        return code;
+        out.indent(indentLevel);
+        traverseOpen.emit(out, { n });
+        out.indent(indentLevel + 1);
+        traverseBody.emit(out, { msg, lastArrayName });
+        out.indent(indentLevel);
+        blockClose.emit(out, {});
+        return;
     }
 
     // Caso normal: "crear lista de enteros con 5 elementos"
-    QString type = "int";
+    const std::string_view type = typeName(deduceType(instruction));
     int size = 0;
 
-    if (instruction.arguments.contains("decimal") || instruction.arguments.contains("decimales")) type = "float";
-    else if (instruction.arguments.contains("texto") || instruction.arguments.contains("string")
-        || instruction.arguments.contains("palabra") || instruction.arguments.contains("cadena")) {
-        type = "string"; needsStringHeader = true;
-    }
-    else if (instruction.arguments.contains("caracter") || instruction.arguments.contains("caracteres")) type = "char";
-
-    for (const auto& arg : instruction.arguments) {
-        bool ok = false;
-        int n = arg.toInt(&ok);
-        if (ok) { size = n; break; }
+    for (std::ptrdiff_t i = 0; i < instruction.argCount(); ++i) {
+        if (instruction.tokens[i].kind != TokenKind::Integer) continue;
+        int n = 0;
+        if (parseInt(instruction.arg(i), n)) { size = n; break; }
     }
 
-    // Nombre por defecto 'lista'; no usar palabras de tipo como nombre
-    QString name = "lista";
-    const QSet<QString> banned = { "crear","lista","arreglo","de","con","elementos",
-                                  "entero","enteros","decimal","decimales","texto",
-                                  "string","palabra","cadena","caracter","caracteres","booleano","bool" };
-    for (const auto& a : instruction.arguments) {
-        if (isIdentifier(a) && !banned.contains(a)) { name = a; break; }
+    // Nombre por defecto 'lista'; las palabras reservadas (tipos, "de"...) no cuentan
+    std::string_view name = "lista";
+    for (std::ptrdiff_t i = 0; i < instruction.argCount(); ++i) {
+        if (instruction.tokens[i].kind == TokenKind::Identifier) { name = instruction.arg(i); break; }
     }
 
+    out.indent(indentLevel);
     if (size > 0) {
-        lastArrayName = name;
+        lastArrayName.assign(name);
+        arrayCreated = true;
         lastArraySize = size;
-        return indent + type + " " + name + "[" + QString::number(size) + "];";
+        arrayDeclaration.emit(out, { type, name, NumberText(size) });
+        return;
     }
 
-    return indent + "// Error: invalid array creation";
+    writeError(out, "invalid array creation");
 }
 
-// Control: if, else, while, for, repetir/hasta que
-QString CodeGenerator::generateControlStructure(const Instruction& instruction, int indentLevel)
+// Control: if, else, while, for, repetir/hasta que. Solo la apertura: el
+// cuerpo y el cierre los escribe generateBlock.
+bool CodeGenerator::openControlStructure(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
-    QString code;
-
     // ---- IF ----
-    if (instruction.arguments.contains("si")) {
-        QString cond = buildCondition(instruction);
-        code += indent + "if (" + cond + ") {\n";
-        code += generateNestedCode(instruction.nested, indentLevel + 1);
-        code += indent + "}";
-        return code;
+    if (instruction.hasArg("si")) {
+        out.indent(indentLevel);
+        ifOpen.emit(out, { buildCondition(instruction) });
+        return true;
     }
 
     // ---- ELSE ----
-    if (instruction.arguments.contains("sino")) {
-        code += indent + "else {\n";
-        code += generateNestedCode(instruction.nested, indentLevel + 1);
-        code += indent + "}";
-        return code;
+    if (instruction.hasArg("sino")) {
+        out.indent(indentLevel);
+        elseOpen.emit(out, {});
+        return true;
     }
 
     // ---- WHILE ----
-    if (instruction.arguments.contains("mientras")) {
-        QString cond = buildCondition(instruction);
-        code += indent + "while (" + cond + ") {\n";
-        code += generateNestedCode(instruction.nested, indentLevel + 1);
-        code += indent + "}";
-        return code;
+    if (instruction.hasArg("mientras")) {
+        out.indent(indentLevel);
+        whileOpen.emit(out, { buildCondition(instruction) });
+        return true;
     }
 
     // ---- FOR ----  "para i desde 0 hasta 4"  -> i <= 4
-    if (instruction.arguments.contains("para")) {
-        QString var = "i";
-        QString start = "0";
-        QString end = "0";
-
-        for (int i = 0; i < instruction.arguments.size(); ++i) {
-            if (instruction.arguments[i] == "para" && i + 1 < instruction.arguments.size())
-                var = instruction.arguments[i + 1];
-            if (instruction.arguments[i] == "desde" && i + 1 < instruction.arguments.size())
-                start = instruction.arguments[i + 1];
-            if (instruction.arguments[i] == "hasta" && i + 1 < instruction.arguments.size())
-                end = instruction.arguments[i + 1];
+    if (instruction.hasArg("para")) {
+        std::string_view var = "i";
+        std::string_view start = "0";
+        std::string_view end = "0";
+
+        for (int i = 0; i < instruction.argCount(); ++i) {
+            if (instruction.arg(i) == "para" && i + 1 < instruction.argCount())
+                var = instruction.arg(i + 1);
+            if (instruction.arg(i) == "desde" && i + 1 < instruction.argCount())
+                start = instruction.arg(i + 1);
+            if (instruction.arg(i) == "hasta" && i + 1 < instruction.argCount())
+                end = instruction.arg(i + 1);
         }
 
-        code += indent + "for (int " + var + " = " + start + "; " + var + " <= " + end + "; " + var + "++) {\n";
-        code += generateNestedCode(instruction.nested, indentLevel + 1);
-        code += indent + "}";
-        return code;
+        out.indent(indentLevel);
+        forOpen.emit(out, { var, start, end });
+        return true;
     }
 
     // ---- DO (repetir) ----
-    if (instruction.keyword.startsWith("repetir") || instruction.arguments.contains("repetir")) {
-        code += indent + "do {\n";
-        code += generateNestedCode(instruction.nested, indentLevel + 1);
-        code += indent + "}";
-        return code; // el 'while (...)' lo imprime 'hasta que'
+    if (instruction.phrase == Phrase::Repetir || instruction.phrase == Phrase::RepetirHasta ||
+        instruction.hasArg("repetir")) {
+        out.indent(indentLevel);
+        doOpen.emit(out, {});
+        return true; // el 'while (...)' lo imprime 'hasta que'
     }
 
     // ---- HASTA QUE ----  -> cierra el do while:    } while (cond);
-    if (instruction.keyword.startsWith("hasta") || instruction.arguments.contains("hasta")) {
-        QString cond = buildCondition(instruction);
-        code = " " + indent + "while (" + cond + ");";
-        return code;
+    if (instruction.phrase == Phrase::Hasta || instruction.phrase == Phrase::HastaQue ||
+        instruction.hasArg("hasta")) {
+        out << " ";
+        out.indent(indentLevel);
+        doClose.emit(out, { buildCondition(instruction) });
+        return false;
     }
 
-    return indent + "// Error: invalid control structure";
+    out.indent(indentLevel);
+    writeError(out, "invalid control structure");
+    return false;
 }
 
-QString CodeGenerator::buildCondition(const Instruction& instruction)
+std::string_view CodeGenerator::buildCondition(const Instruction& instruction)
 {
-    // Copia de los argumentos
-    QStringList args = instruction.arguments;
+    const std::ptrdiff_t count = instruction.argCount();
 
     // Guardar keyword original (si, mientras, hasta…)
-    QString keyword = args.isEmpty() ? "" : args.first();
+    const std::string_view keyword = count > 0 ? instruction.arg(0) : std::string_view();
+
+    // Salta solo la palabra clave de control
+    std::ptrdiff_t first = count > 0 ? 1 : 0;
+    if (first < count && instruction.arg(first) == "que") first++;
 
-    // Quita solo la palabra clave de control
-    if (!args.isEmpty()) args.removeFirst();
-    if (!args.isEmpty() && args.front() == "que") args.removeFirst();
+    // Caso especial: "hasta que" → negamos la condición
+    const bool negate = keyword == "hasta";
 
-    QString cond;
-    for (int i = 0; i < args.size(); ++i) {
-        QString token = args[i];
+    std::string& cond = scratch;
+    cond.resize(0);
+    if (negate) cond += "!(";
+    for (std::ptrdiff_t i = first; i < count; ++i) {
+        const std::string_view token = instruction.arg(i);
+        const std::string_view next = (i + 1 < count) ? instruction.arg(i + 1) : std::string_view();
 
-        if (token == "igual" && i + 1 < args.size() && args[i + 1] == "a") {
+        if (token == "igual" && next == "a") {
             cond += "=="; i++;
         }
-        else if (token == "diferente" && i + 1 < args.size() && args[i + 1] == "de") {
+        else if (token == "diferente" && next == "de") {
             cond += "!="; i++;
         }
-        else if (token == "mayor" && i + 1 < args.size() && args[i + 1] == "que") {
-            cond += ">"; i++;
+        else if (token == "mayor" && next == "que") {
+            cond += '>'; i++;
         }
-        else if (token == "menor" && i + 1 < args.size() && args[i + 1] == "que") {
-            cond += "<"; i++;
+        else if (token == "menor" && next == "que") {
+            cond += '<'; i++;
         }
         else if (token == "y") cond += "&&";
         else if (token == "o") cond += "||";
         else cond += token;
 
-        cond += " ";
+        cond += ' ';
     }
 
-    cond = cond.trimmed();
-
-    // Caso especial: "hasta que" → negamos la condición
-    if (keyword == "hasta") {
-        return "!(" + cond + ")";
-    }
+    // Solo se quita el separador final: los espacios dentro de un literal
+    // entre comillas son parte del token y se conservan
+    if (!cond.empty() && cond.back() == ' ') cond.pop_back();
+    if (negate) cond += ')';
 
     return cond;
 }
@@ -423,152 +787,180 @@ QString CodeGenerator::buildCondition(const Instruction& instruction)
 
 
 // Entrada: "leer x"
-QString CodeGenerator::generateInput(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateInput(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
-    if (instruction.arguments.size() >= 2) {
-        QString varName = instruction.arguments.last();
-        return indent + "cin >> " + varName + ";";
+    out.indent(indentLevel);
+    if (instruction.argCount() >= 2) {
+        input.emit(out, { instruction.lastArg() });
+        return;
     }
-    return indent + "// Error: invalid input";
+    writeError(out, "invalid input");
 }
 
 // Salida: "mostrar resultado" o "mostrar \"El resultado es\""
-QString CodeGenerator::generateOutput(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateOutput(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
-    if (instruction.arguments.size() >= 2) {
-        // Unimos todo lo que venga después de "mostrar"
-        QString arg = instruction.arguments.mid(1).join(" ");
-
-        // Si viene entre comillas, respetarlo
-        if (arg.startsWith("\"") && arg.endsWith("\"")) {
-            return indent + "cout << " + arg + " << endl;";
-        }
-
-        // Si no, lo tratamos como variable/expresión
-        return indent + "cout << " + arg + " << endl;";
-    }
-    return indent + "// Error: invalid output";
+    out.indent(indentLevel);
+    if (instruction.argCount() >= 2) {
+        // Todo lo que venga después de "mostrar": un literal entre comillas se
+        // respeta tal cual y cualquier otra cosa se trata como variable/expresión
+        output.emit(out, { instruction.argsFrom(1) });
+        return;
+    }
+    writeError(out, "invalid output");
 }
 
 
 // ===== Funciones =====
-QString CodeGenerator::generateFunctionDefinition(const Instruction& instruction)
+void CodeGenerator::generateFunctionDefinition(const Instruction& instruction, CodeSink& out)
 {
-    // Nombre de la función: segunda palabra tras "definir"
-    QString funcName = "funcion";
-    for (int i = 0; i < instruction.arguments.size(); ++i) {
-        if (instruction.arguments[i] == "funcion" && i + 1 < instruction.arguments.size()) {
-            funcName = instruction.arguments[i + 1];
-            break;
+    std::string_view funcName;
+    const SymbolId funcId = functionName(instruction, &funcName);
+
+    signatureOpen.emit(out, { funcName });
+    writeParameters(funcId, out);
+    signatureClose.emit(out, {});
+    generateBlock(instruction.nested, 1, false, out);
+    out << "}\n";
+}
+
+// Parámetros: las variables declaradas que usa el cuerpo (las resolvió el análisis)
+void CodeGenerator::writeParameters(SymbolId funcId, CodeSink& out)
+{
+    if (const ParamRange* params = functionParams.find(funcId)) {
+        for (std::uint32_t i = 0; i < params->count; ++i) {
+            const SymbolId id = paramPool[params->begin + i];
+            if (i) out << ", ";
+            parameter.emit(out, { typeName(*symbols.find(id)), names->text(id) });
         }
     }
+}
 
-    // Deducción de parámetros: si el cuerpo usa variables conocidas, las pasamos por valor.
-    QSet<QString> used;
-    struct ScanUseHelper {
-        static void scan(const std::vector<Instruction>& nested, const QMap<QString, QString>& symbols, QSet<QString>& used) {
-            for (const auto& ins : nested) {
-                for (const auto& t : ins.arguments) {
-                    if (symbols.contains(t)) used.insert(t);
-                }
-                if (!ins.nested.empty()) scan(ins.nested, symbols, used);
-            }
-        }
-    };
-    ScanUseHelper::scan(instruction.nested, symbols, used);
+// ==================== PROYECTOS DE VARIOS ARCHIVOS ====================
 
-    QStringList paramDecls, paramNames;
-    for (const auto& name : used) {
-        QString type = symbols.value(name, "int");
-        if (type == "string") needsStringHeader = true;
-        paramDecls << (type + " " + name);
-        paramNames << name;
+void CodeGenerator::functionParameters(SymbolId function, std::vector<SymbolId>& params) const
+{
+    params.clear();
+    if (const ParamRange* range = functionParams.find(function)) {
+        params.assign(paramPool.begin() + range->begin, paramPool.begin() + range->begin + range->count);
     }
-    functionParamTypes[funcName] = [&] {
-        QStringList ts;
-        for (const auto& n : paramNames) ts << symbols.value(n, "int");
-        return ts;
-        }();
-    functionParamNames[funcName] = paramNames;
+}
 
-    QString sig = "void " + funcName + "(" + paramDecls.join(", ") + ")";
-    QString body = "{\n" + generateNestedCode(instruction.nested, 1) + "}\n";
-    return sig + " " + body;
+void CodeGenerator::writeHeader(const std::vector<SymbolId>& functions, CodeSink& out)
+{
+    out << "#pragma once\n\n";
+    writePrologue(out);
+    for (SymbolId function : functions) {
+        signatureOpen.emit(out, { names->text(function) });
+        writeParameters(function, out);
+        prototypeClose.emit(out, {});
+    }
+}
+
+void CodeGenerator::writeUnitPrologue(std::string_view headerName, CodeSink& out)
+{
+    out << "#include \"" << headerName << "\"\n\n";
 }
 
 // Llamado: "llamar funcion nombre"
-QString CodeGenerator::generateFunctionCall(const Instruction& instruction, int indentLevel)
+void CodeGenerator::generateFunctionCall(const Instruction& instruction, int indentLevel, CodeSink& out)
 {
-    QString indent(indentLevel * 4, ' ');
-    QString funcName = "funcion";
-    for (int i = 0; i < instruction.arguments.size(); ++i) {
-        if (instruction.arguments[i] == "funcion" && i + 1 < instruction.arguments.size()) {
-            funcName = instruction.arguments[i + 1];
-            break;
+    std::string_view funcName;
+    const SymbolId funcId = functionName(instruction, &funcName);
+
+    out.indent(indentLevel);
+    callOpen.emit(out, { funcName });
+    if (const ParamRange* params = functionParams.find(funcId)) {
+        for (std::uint32_t i = 0; i < params->count; ++i) {
+            if (i) out << ", ";
+            out << names->text(paramPool[params->begin + i]);
         }
     }
-
-    QStringList args;
-    if (functionParamNames.contains(funcName)) {
-        for (const auto& pn : functionParamNames[funcName]) args << pn;
-    }
-    return indent + funcName + "(" + args.join(", ") + ");";
+    callClose.emit(out, {});
 }
 
 // ===== Utilidades generales =====
-bool CodeGenerator::isIdentifier(const QString& tok) {
-    if (tok.isEmpty()) return false;
-    static QRegularExpression rx("^[A-Za-z_][A-Za-z0-9_]*$");
-    return rx.match(tok).hasMatch();
-}
-bool CodeGenerator::isNumber(const QString& tok) {
-    bool ok = false; tok.toDouble(&ok); return ok;
-}
-
-QString CodeGenerator::joinArguments(const QStringList& args, const QString& separator)
+bool CodeGenerator::generateStatement(const Instruction& inst, int indentLevel, CodeSink& out)
 {
-    return args.join(" " + separator + " ");
+    switch (inst.type) {
+    case InstructionType::Arithmetic:
+        generateArithmetic(inst, indentLevel, out);
+        break;
+    case InstructionType::VariableDeclaration:
+        generateVariableDeclaration(inst, indentLevel, out);
+        break;
+    case InstructionType::Assignment:
+        generateAssignment(inst, indentLevel, out);
+        break;
+    case InstructionType::ArrayCreation:
+        generateArrayCreation(inst, indentLevel, out);
+        break;
+    case InstructionType::Input:
+        generateInput(inst, indentLevel, out);
+        break;
+    case InstructionType::Output:
+        generateOutput(inst, indentLevel, out);
+        break;
+    case InstructionType::FunctionCall:
+        generateFunctionCall(inst, indentLevel, out);
+        break;
+    default:
+        return false;
+    }
+    out << "\n";
+    return true;
 }
 
-QString CodeGenerator::generateNestedCode(const std::vector<Instruction>& nested, int indentLevel)
+// Un solo bucle recorre todo el anidamiento: cada estructura de control con
+// cuerpo apila un nivel y, al agotarse el nivel, se escribe su cierre
+void CodeGenerator::generateBlock(InstructionList instructions, int indentLevel, bool mainBody, CodeSink& out)
 {
-    QString code;
+    const std::size_t base = outputLevels.size();
+    outputLevels.push_back({ instructions.begin(), instructions.end(), indentLevel });
+
+    while (outputLevels.size() > base) {
+        OutputLevel& level = outputLevels.back();
+
+        // Al cancelar no se escriben más sentencias, pero se cierran los bloques abiertos
+        if (level.next != level.end && cancelled()) level.next = level.end;
+
+        if (level.next == level.end) {
+            const int closedLevel = level.indentLevel - 1;
+            outputLevels.pop_back();
+            if (outputLevels.size() > base) {
+                out.indent(closedLevel);
+                blockClose.emit(out, {});
+                out << "\n";
+            }
+            continue;
+        }
 
-    for (const auto& inst : nested) {
-        switch (inst.type) {
-        case InstructionType::Arithmetic:
-            code += generateArithmetic(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::VariableDeclaration:
-            code += generateVariableDeclaration(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::Assignment:
-            code += generateAssignment(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::ArrayCreation:
-            code += generateArrayCreation(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::ControlStructure:
-            code += generateControlStructure(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::Input:
-            code += generateInput(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::Output:
-            code += generateOutput(inst, indentLevel) + "\n";
-            break;
-        case InstructionType::FunctionDefinition:
-            // definiciones anidadas: evitamos imprimir aquí
-            break;
-        case InstructionType::FunctionCall:
-            code += generateFunctionCall(inst, indentLevel) + "\n";
-            break;
-        default:
-            code += QString(indentLevel * 4, ' ') + "// [WARN] Unknown nested instruction: " + inst.keyword + "\n";
-            break;
+        const Instruction& inst = *level.next++;
+        const int indent = level.indentLevel;
+        const bool inMain = mainBody && outputLevels.size() == base + 1;
+
+        // Definiciones: las de nivel superior ya se escribieron antes de main;
+        // las anidadas en un bloque se omiten
+        if (inst.type == InstructionType::FunctionDefinition) continue;
+        if (inMain && (inst.type == InstructionType::ProgramStart || inst.type == InstructionType::ProgramEnd)) continue;
+
+        if (inst.type == InstructionType::ControlStructure) {
+            if (openControlStructure(inst, indent, out)) {
+                outputLevels.push_back({ inst.nested.begin(), inst.nested.end(), indent + 1 });
+            }
+            else {
+                out << "\n";
+            }
+            continue;
+        }
+
+        if (generateStatement(inst, indent, out)) continue;
+        if (inMain) {
+            out << "    // [WARN] Unknown instruction: " << inst.keyword << "\n";
+        }
+        else {
+            out.indent(indent);
+            out << "// [WARN] Unknown nested instruction: " << inst.keyword << "\n";
         }
     }
-    return code;
 }
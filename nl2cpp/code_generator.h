@@ -1,10 +1,15 @@
 #pragma once
 
-#include <QString>
-#include <QSet>
-#include <QMap>
+#include <cstddef>
+#include <string>
+#include <string_view>
 #include <vector>
 #include "natural_language_processor.h"
+#include "flat_map.h"
+#include "code_sink.h"
+#include "conversion_observer.h"
+
+struct ConversionStats;
 
 class CodeGenerator
 {
@@ -12,55 +17,229 @@ public:
     CodeGenerator();
     ~CodeGenerator();
 
-    // Genera cdigo C++ a partir de un conjunto de instrucciones
-    QString generateCode(const std::vector<Instruction>& instructions);
+    // Versin del cdigo generado: sbela cuando la misma entrada pase a
+    // producir otra salida (invalida las entradas de ConversionCache)
+    static constexpr int outputVersion = 5;
+
+    // Genera cdigo C++ (UTF-8) a partir de un conjunto de instrucciones
+    std::string generateCode(const Program& program);
+
+    // Igual, pero escribiendo directamente en 'out' (memoria, archivo, tubera...)
+    void generateCode(const Program& program, CodeSink& out);
+
+    // Tamao aproximado de la salida, para reservar el buffer de una sola vez
+    static std::size_t estimateSize(const Program& program);
+
+    // Cancelacin cooperativa (nullptr = sin observador)
+    void setObserver(ConversionObserver* conversionObserver) { observer = conversionObserver; }
+
+    // Mtricas de generateCode (nullptr = desactivadas)
+    void setStats(ConversionStats* conversionStats) { stats = conversionStats; }
+
+    // Hilos para generar las definiciones de funciones (0 = automtico, 1 = en
+    // serie). La salida es idntica con cualquier cantidad de hilos.
+    void setThreadCount(int count) { threadCount = count; }
+
+    // Tipos C++ que puede tener una variable declarada
+    enum class CppType : std::uint8_t { Int, Float, String, Char, Bool };
+
+    // ===== Generacin por fragmentos (conversin incremental) =====
+    // generateCode equivale a: beginProgram, analyze, resolveFunctions,
+    // writePrologue, writeFunctionDefinitions, writeMainOpen, writeStatements,
+    // writeEpilogue y endProgram sobre todo el programa. IncrementalConverter llama a los mismos
+    // pasos unidad por unidad y reutiliza los fragmentos que no cambiaron.
+
+    // Estado global que lee un fragmento: si coincide con el de una generacin
+    // anterior, el fragmento produce exactamente el mismo texto.
+    struct FragmentState {
+        std::uint64_t symbolsHash = 0;
+        std::uint64_t paramsHash = 0;
+        std::string lastArrayName;
+        int lastArraySize = 0;
+
+        bool operator==(const FragmentState& other) const {
+            return symbolsHash == other.symbolsHash && paramsHash == other.paramsHash &&
+                   lastArraySize == other.lastArraySize && lastArrayName == other.lastArrayName;
+        }
+        bool operator!=(const FragmentState& other) const { return !(*this == other); }
+    };
+
+    // Escrituras de un fragmento sobre el estado global, para reproducirlas sin regenerarlo
+    struct FragmentEffects {
+        std::vector<std::pair<SymbolId, CppType>> symbols;
+        std::vector<std::pair<SymbolId, std::vector<SymbolId>>> functionUses;
+        bool needsString = false;
+        bool needsResultado = false;
+        std::string lastArrayName;  // estado del ltimo arreglo al terminar
+        int lastArraySize = 0;
+        bool readsArray = false;    // ley el arreglo de entrada antes de crear uno
+        bool createsArray = false;
+
+        void clear();
+    };
+
+    void beginProgram(const Interner& programNames);
+    void endProgram();
+
+    // Anlisis semntico: un solo recorrido que llena el modelo (tipos de las
+    // variables, variables que usa cada funcin, <string> y 'resultado')
+    void analyze(InstructionList instructions, FragmentEffects* effects = nullptr);
+
+    // Parmetros de cada funcin; se llama una vez analizado todo el programa
+    void resolveFunctions();
+
+    void writePrologue(CodeSink& out);
+    void writeFunctionDefinitions(InstructionList instructions, CodeSink& out, FragmentEffects* effects = nullptr);
+    void writeMainOpen(CodeSink& out);
+    void writeStatements(InstructionList instructions, CodeSink& out, FragmentEffects* effects = nullptr);
+    void writeEpilogue(CodeSink& out);
+
+    // Aplica las escrituras registradas de un fragmento reutilizado
+    void replay(const FragmentEffects& effects);
+
+    // Estado de entrada de un fragmento; las sentencias de main no leen 'symbols'
+    FragmentState fragmentState(bool readsSymbols) const;
+
+    // ===== Proyectos de varios archivos (ver ProjectConverter) =====
+    // Consultas sobre el modelo ya resuelto: tipo de una variable (nullptr si
+    // no est declarada) y parmetros de una funcin
+    const CppType* symbolType(SymbolId id) const { return symbols.find(id); }
+    void functionParameters(SymbolId function, std::vector<SymbolId>& params) const;
+
+    // Cabecera comn: includes y el prototipo de cada funcin de 'functions'
+    void writeHeader(const std::vector<SymbolId>& functions, CodeSink& out);
+    // Inicio de una unidad de traduccin: incluye la cabecera comn
+    void writeUnitPrologue(std::string_view headerName, CodeSink& out);
 
 private:
-    // ===== Estado de generacin (se reinicia en cada generateCode) =====
+    // ===== Modelo semntico (lo llena analyze; la generacin solo lo lee) =====
     bool needsStringHeader = false;
     bool needsResultado = false;
-    bool insideMain = false;
+
+    // Rango de parmetros de una funcin dentro de 'paramPool'
+    struct ParamRange {
+        std::uint32_t begin = 0;
+        std::uint32_t count = 0;
+        std::uint64_t hash = 0;     // aporte a 'paramsHash'
+    };
+
+    // Palabras internadas del programa que se est generando
+    const Interner* names = nullptr;
 
     // Smbolos declarados en el programa (nombre -> tipo C++)
-    QMap<QString, QString> symbols;
+    FlatMap<CppType> symbols;
 
-    // Prototipos de funciones: nombre -> lista tipos de parmetros
-    QMap<QString, QStringList> functionParamTypes;
-    // Parmetros por nombre de funcin
-    QMap<QString, QStringList> functionParamNames;
+    // Palabras que aparecen en el cuerpo de cada definicin de nivel superior,
+    // sin repetir; resolveFunctions se queda con las que son variables
+    struct FunctionUses {
+        SymbolId function = NoSymbol;
+        std::uint32_t begin = 0;    // rango dentro de 'usePool'
+        std::uint32_t count = 0;
+    };
+    std::vector<FunctionUses> functionUses;
+    std::vector<SymbolId> usePool;
+    FlatMap<std::uint32_t> useMark;     // ltima definicin (1..n) que registr cada palabra
+
+    // Parmetros por nombre de funcin; sus tipos se leen de 'symbols'
+    FlatMap<ParamRange> functionParams;
+    std::vector<SymbolId> paramPool;
+    std::vector<SymbolId> paramScratch;
+
+    // ===== Estado de generacin (se reinicia en cada generateCode) =====
+    bool insideMain = false;
 
     // Memoria del ltimo arreglo para soportar "recorrer la lista ..."
-    QString lastArrayName = "lista";
+    std::string lastArrayName = "lista";
     int     lastArraySize = 0;
 
+    // Si la funcin o el fragmento en curso cre un arreglo, o ley el heredado
+    // antes de crearlo (generacin en paralelo y FragmentEffects)
+    bool arrayCreated = false;
+    bool inheritedArrayRead = false;
+
+    int threadCount = 0;
+    std::vector<const Instruction*> definitionList;
+
+    // Huellas de 'symbols' y 'functionParams' (suma de un hash por entrada)
+    std::uint64_t symbolsHash = 0;
+    std::uint64_t paramsHash = 0;
+
+    // Fragmento en curso cuyas escrituras se registran (o nullptr)
+    FragmentEffects* journal = nullptr;
+
+    ConversionObserver* observer = nullptr;
+    bool cancelled() const { return observer && observer->isCancelled(); }
+
+    ConversionStats* stats = nullptr;
+
+    // Buffer reutilizable para condiciones y mensajes: conserva su capacidad
+    std::string scratch;
+
     // ===== Utilidades =====
     void resetState();
+    static std::string_view typeName(CppType type);
+    void writeError(CodeSink& out, const char* message);
+    static CppType deduceType(const Instruction& instruction);
+    SymbolId functionName(const Instruction& instruction, std::string_view* text) const;
+
+    // Toda escritura del estado global pasa por aqu (huellas y registro)
+    void setSymbol(SymbolId id, CppType type);
+    void setFunctionParams(SymbolId funcId, const SymbolId* params, std::size_t count);
+    void requireString();
+    void requireResultado();
+    void addFunctionUses(SymbolId funcId, const SymbolId* uses, std::size_t count);
+
+    void openJournal(FragmentEffects* effects);
+    void closeJournal();
+
+    // Recorridos del rbol con una pila propia en lugar de recursin: la
+    // profundidad del anidamiento solo est limitada por la memoria
+    struct AnalysisLevel {
+        const Instruction* next;
+        const Instruction* end;
+        int function;           // ndice en 'functionUses' de la definicin en curso, o -1
+        bool definition;        // el nivel es el cuerpo de esa definicin
+    };
+    std::vector<AnalysisLevel> analysisLevels;
+
+    struct OutputLevel {
+        const Instruction* next;
+        const Instruction* end;
+        int indentLevel;
+    };
+    std::vector<OutputLevel> outputLevels;
 
-    // Pre-scan para recopilar variables y decidir includes
-    void collectSymbols(const std::vector<Instruction>& instructions);
-    void collectSymbolsFromBlock(const std::vector<Instruction>& nested);
+    // Recorrido del anlisis (ver analyzeInstruction)
+    void analyzeBlock(InstructionList instructions);
+    // 'function' es la definicin en curso (o nullptr)
+    void analyzeInstruction(const Instruction& instruction, FunctionUses* function);
 
-    // Generacin de bloques/anidados
-    QString generateNestedCode(const std::vector<Instruction>& nested, int indentLevel);
+    // Definiciones de funciones repartidas entre hilos y cosidas en orden
+    void writeDefinitionsParallel(int threads, CodeSink& out);
 
-    // Mtodos auxiliares para cada tipo de instruccin
-    QString generateArithmetic(const Instruction& instruction, int indentLevel = 0);
-    QString generateVariableDeclaration(const Instruction& instruction, int indentLevel = 0);
-    QString generateAssignment(const Instruction& instruction, int indentLevel = 0);
-    QString generateArrayCreation(const Instruction& instruction, int indentLevel = 0);
-    QString generateControlStructure(const Instruction& instruction, int indentLevel = 0);
-    QString buildCondition(const Instruction& instruction);
+    // Generacin de bloques/anidados. 'mainBody' es el cuerpo de main, que
+    // adems omite el inicio y el fin de programa.
+    void generateBlock(InstructionList instructions, int indentLevel, bool mainBody, CodeSink& out);
 
-    QString generateInput(const Instruction& instruction, int indentLevel = 0);
-    QString generateOutput(const Instruction& instruction, int indentLevel = 0);
+    // Escribe una sentencia simple y su salto de lnea; false si el tipo no
+    // genera sentencia (las estructuras de control las escribe generateBlock)
+    bool generateStatement(const Instruction& instruction, int indentLevel, CodeSink& out);
 
-    QString generateFunctionDefinition(const Instruction& instruction);
-    QString generateFunctionCall(const Instruction& instruction, int indentLevel = 0);
+    // Mtodos auxiliares para cada tipo de instruccin (sin salto de lnea final)
+    void generateArithmetic(const Instruction& instruction, int indentLevel, CodeSink& out);
+    void generateVariableDeclaration(const Instruction& instruction, int indentLevel, CodeSink& out);
+    void generateAssignment(const Instruction& instruction, int indentLevel, CodeSink& out);
+    void generateArrayCreation(const Instruction& instruction, int indentLevel, CodeSink& out);
+    // Escribe la apertura; true si sigue un cuerpo que generateBlock escribe y cierra
+    bool openControlStructure(const Instruction& instruction, int indentLevel, CodeSink& out);
+    // Escribe la condicin en 'scratch' (sin asignaciones tras la primera vez)
+    std::string_view buildCondition(const Instruction& instruction);
 
-    // Deteccin de identificadores vlidos (variables) o nmeros
-    static bool isIdentifier(const QString& tok);
-    static bool isNumber(const QString& tok);
+    void generateInput(const Instruction& instruction, int indentLevel, CodeSink& out);
+    void generateOutput(const Instruction& instruction, int indentLevel, CodeSink& out);
 
-    // Utilidad para concatenar argumentos en una sola cadena
-    QString joinArguments(const QStringList& args, const QString& separator);
+    void generateFunctionDefinition(const Instruction& instruction, CodeSink& out);
+    // Lista de parmetros de una firma (definicin o prototipo)
+    void writeParameters(SymbolId funcId, CodeSink& out);
+    void generateFunctionCall(const Instruction& instruction, int indentLevel, CodeSink& out);
 };
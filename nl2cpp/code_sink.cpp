@@ -0,0 +1,45 @@
+﻿#include "stdafx.h"
+#include "code_sink.h"
+#include "emit_template.h"
+
+#include <algorithm>
+
+// ==================== ESCRITURA COMÚN ====================
+
+void CodeSink::indent(int level)
+{
+    // Tramos largos: con anidamientos profundos la sangría es casi toda la salida
+    static const std::string spaces(256, ' ');
+    const std::size_t chunk = spaces.size();
+
+    for (std::size_t n = std::size_t(std::max(level, 0)) * 4; n > 0; n -= std::min(n, chunk)) {
+        write(std::string_view(spaces.data(), std::min(n, chunk)));
+    }
+}
+
+CodeSink& CodeSink::operator<<(int number)
+{
+    write(NumberText(number));
+    return *this;
+}
+
+// ==================== TEXTO EN MEMORIA ====================
+
+StringSink::StringSink(std::string& target, std::size_t expectedSize)
+    : target(target)
+{
+    if (expectedSize > 0) target.reserve(target.size() + expectedSize);
+}
+
+// ==================== STD::OSTREAM ====================
+
+void StdStreamSink::write(std::string_view text)
+{
+    stream.write(text.data(), std::streamsize(text.size()));
+}
+
+bool StdStreamSink::flush()
+{
+    stream.flush();
+    return bool(stream);
+}
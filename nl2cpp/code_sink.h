@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Destino del código generado (UTF-8): el generador escribe cada fragmento una
+// sola vez, directamente en el sink, en lugar de devolver strings que cada
+// nivel de anidamiento vuelve a copiar.
+class CodeSink
+{
+public:
+    virtual ~CodeSink() = default;
+
+    virtual void write(std::string_view text) = 0;
+
+    // Vacía lo que quede en buffers intermedios. Devuelve false si falló la escritura.
+    virtual bool flush() { return true; }
+
+    // Sangría de 'level' niveles de 4 espacios
+    void indent(int level);
+
+    CodeSink& operator<<(std::string_view text) { write(text); return *this; }
+    CodeSink& operator<<(const std::string& text) { write(text); return *this; }
+    CodeSink& operator<<(const char* text) { write(text); return *this; }
+    CodeSink& operator<<(char c) { write(std::string_view(&c, 1)); return *this; }
+    CodeSink& operator<<(int number);
+};
+
+// Escribe en un std::string en memoria, reservado de antemano según una estimación
+class StringSink : public CodeSink
+{
+public:
+    explicit StringSink(std::string& target, std::size_t expectedSize = 0);
+    void write(std::string_view text) override { target.append(text); }
+
+private:
+    std::string& target;
+};
+
+// Escribe en un std::ostream (por ejemplo std::cout en una tubería); el
+// streambuf ya acumula por bloques
+class StdStreamSink : public CodeSink
+{
+public:
+    explicit StdStreamSink(std::ostream& stream) : stream(stream) {}
+    ~StdStreamSink() override { flush(); }
+
+    void write(std::string_view text) override;
+    bool flush() override;
+
+private:
+    std::ostream& stream;
+};
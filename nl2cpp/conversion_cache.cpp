@@ -0,0 +1,139 @@
+﻿#include "stdafx.h"
+#include "conversion_cache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Cabecera de cada entrada: "nl2cpp-cache <bytes UTF-8>\n"; detecta archivos truncados o ajenos
+const QByteArray entryMagic = QByteArrayLiteral("nl2cpp-cache ");
+
+} // namespace
+
+// ==================== CONSTRUCTOR ====================
+ConversionCache::ConversionCache(const QString& directory, qint64 maxBytes)
+    : root(directory), limit(maxBytes)
+{
+}
+
+// Dos niveles de directorio para no juntar miles de archivos en uno solo
+QString ConversionCache::pathFor(const CacheKey& key) const
+{
+    const QString hex = QString::fromStdString(key.toHex());
+    return root + u'/' + hex.left(2) + u'/' + hex.mid(2) + QStringLiteral(".cpp");
+}
+
+// ==================== LECTURA ====================
+
+bool ConversionCache::lookup(const CacheKey& key, std::string& output)
+{
+    QFile file(pathFor(key));
+
+    // Con escritura se puede renovar la fecha (LRU); sin permiso, solo se lee
+    const bool writable = file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly);
+    if (!writable && !file.open(QIODevice::ReadOnly)) {
+        ++missCount;
+        return false;
+    }
+
+    const QByteArray header = file.readLine(64);
+    bool ok = header.startsWith(entryMagic) && header.endsWith('\n');
+    const qint64 size = ok ? header.mid(entryMagic.size(), header.size() - entryMagic.size() - 1).toLongLong(&ok) : 0;
+
+    const QByteArray bytes = ok ? file.readAll() : QByteArray();
+    if (!ok || bytes.size() != size) {
+        ++missCount;    // entrada dañada: la próxima conversión la reemplaza
+        return false;
+    }
+
+    if (writable) file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+
+    output.assign(bytes.constData(), std::size_t(bytes.size()));
+    ++hitCount;
+    return true;
+}
+
+// ==================== ESCRITURA ====================
+
+void ConversionCache::store(const CacheKey& key, std::string_view output)
+{
+    const QString path = pathFor(key);
+    if (!QDir().mkpath(QFileInfo(path).path())) return;
+
+    const QByteArray bytes = QByteArray::fromRawData(output.data(), qsizetype(output.size()));
+    const QByteArray header = entryMagic + QByteArray::number(bytes.size()) + '\n';
+
+    // Temporal + renombrado: otro proceso nunca ve la entrada a medio escribir
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    file.write(header);
+    file.write(bytes);
+    if (!file.commit()) return;
+
+    bool overLimit = false;
+    {
+        std::lock_guard<std::mutex> lock(sizeMutex);
+        if (knownBytes < 0) scanSize();
+        else knownBytes += header.size() + bytes.size();
+        overLimit = knownBytes > limit;
+    }
+    if (overLimit) evict();
+}
+
+// ==================== DESALOJO ====================
+
+// Solo cuenta lo que hay en disco; lo llama store() con 'sizeMutex' tomado
+void ConversionCache::scanSize()
+{
+    qint64 total = 0;
+    QDirIterator it(root, { QStringLiteral("*.cpp") }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        total += it.fileInfo().size();
+    }
+    knownBytes = total;
+}
+
+void ConversionCache::evict()
+{
+    // Un proceso (o hilo) a la vez; si otro ya está desalojando, no hace falta repetirlo
+    QLockFile lock(root + QStringLiteral("/evict.lock"));
+    if (!lock.tryLock(0)) return;
+
+    struct Entry {
+        QString path;
+        qint64 size;
+        QDateTime used;
+    };
+    std::vector<Entry> entries;
+    qint64 total = 0;
+
+    QDirIterator it(root, { QStringLiteral("*.cpp") }, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        entries.push_back({ info.filePath(), info.size(), info.lastModified() });
+        total += info.size();
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.used < b.used; });
+
+    const qint64 target = limit / 4 * 3;
+    for (const Entry& entry : entries) {
+        if (total <= target) break;
+        // Un archivo abierto por otro proceso puede no borrarse (Windows); queda para la próxima
+        if (QFile::remove(entry.path)) total -= entry.size;
+    }
+
+    std::lock_guard<std::mutex> guard(sizeMutex);
+    knownBytes = total;
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include "output_cache.h"
+
+// Caché persistente de conversiones: la OutputCache de las aplicaciones Qt.
+//
+// Cada entrada es un archivo propio dentro de 'directory'. Se escribe con
+// QSaveFile (archivo temporal + renombrado), así varios procesos pueden usar
+// el mismo directorio a la vez: un lector ve la entrada completa o no la ve.
+// Cada acierto renueva la fecha de modificación del archivo; al pasar de
+// 'maxBytes' se borran las entradas usadas hace más tiempo (LRU) hasta bajar
+// a 3/4 del límite. Una sola instancia puede compartirse entre hilos.
+class ConversionCache : public OutputCache
+{
+public:
+    explicit ConversionCache(const QString& directory, qint64 maxBytes = 256 * 1024 * 1024);
+
+    // Salida guardada para 'key'; false si no está (o el archivo no es válido)
+    bool lookup(const CacheKey& key, std::string& output) override;
+
+    // Guarda 'output' para 'key'; los fallos de escritura se ignoran
+    void store(const CacheKey& key, std::string_view output) override;
+
+    // Borra entradas viejas hasta que el total quede en 3/4 de 'maxBytes'
+    void evict();
+
+    const QString& directory() const { return root; }
+    qint64 maxBytes() const { return limit; }
+
+    int hits() const { return hitCount.load(); }
+    int misses() const { return missCount.load(); }
+
+private:
+    QString pathFor(const CacheKey& key) const;
+    void scanSize();
+
+    QString root;
+    qint64 limit;
+
+    std::mutex sizeMutex;
+    qint64 knownBytes = -1;     // tamaño total estimado (-1 = sin contar aún)
+
+    std::atomic<int> hitCount{ 0 };
+    std::atomic<int> missCount{ 0 };
+};
@@ -0,0 +1,22 @@
+﻿#pragma once
+
+// Observador opcional de una conversión en curso: recibe el avance del parser
+// y puede pedir que se detenga. Lo consultan el parser (una vez por línea) y el
+// generador (una vez por instrucción), normalmente desde un hilo de trabajo,
+// así que las implementaciones deben ser seguras entre hilos.
+//
+// Al cancelar, el parser trata la entrada como terminada y el generador deja
+// de escribir: la conversión vuelve enseguida con una salida incompleta que
+// el llamador debe descartar.
+class ConversionObserver
+{
+public:
+    virtual ~ConversionObserver() = default;
+
+    // Líneas leídas hasta ahora (se informa cada 'reportInterval' líneas)
+    virtual void linesParsed(int count) { (void)count; }
+
+    virtual bool isCancelled() const { return false; }
+
+    static constexpr int reportInterval = 256;
+};
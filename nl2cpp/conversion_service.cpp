@@ -0,0 +1,242 @@
+﻿#include "stdafx.h"
+#include "conversion_service.h"
+#include "conversion_cache.h"
+#include "converter.h"
+#include "keyword_table.h"
+#include "lexer.h"
+#include "line_reader.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <chrono>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Cancela la conversión en curso al vencer el plazo de la petición
+class Deadline : public ConversionObserver
+{
+public:
+    explicit Deadline(Clock::time_point at) : at(at) {}
+
+    bool isCancelled() const override {
+        if (!expired && Clock::now() >= at) expired = true;
+        return expired;
+    }
+
+    // true si el convertidor llegó a ver la cancelación
+    bool fired() const { return expired; }
+
+private:
+    Clock::time_point at;
+    mutable bool expired = false;
+};
+
+QByteArray toLine(const QJsonObject& object)
+{
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+struct ConversionService::Job {
+    QByteArray request;         // línea JSON tal como llegó
+    Clock::time_point received; // el plazo se cuenta desde aquí
+    Reply reply;
+};
+
+// ==================== CONSTRUCTOR ====================
+
+ConversionService::ConversionService(const ServiceLimits& limits, int workerCount, ConversionCache* cache)
+    : serviceLimits(limits), converter(std::make_unique<Converter>())
+{
+    converter->setThreadCount(1);       // el paralelismo ya es por petición
+    converter->setCache(cache);
+
+    const int workers = workerCount > 0 ? workerCount : qMax(1, QThread::idealThreadCount());
+    threads.reserve(std::size_t(workers));
+    for (int i = 0; i < workers; ++i) threads.emplace_back([this] { loop(); });
+}
+
+ConversionService::~ConversionService()
+{
+    std::deque<std::unique_ptr<Job>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(queue);
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) t.join();
+
+    // Lo que no llegó a empezar también recibe respuesta
+    for (const auto& job : abandoned) {
+        job->reply(errorReply(requestId(job->request), "shutdown", "el servicio se detuvo antes de atender la peticion"));
+    }
+}
+
+// ==================== PETICIONES ====================
+
+void ConversionService::handle(const QByteArray& line, Reply reply)
+{
+    if (line.size() > serviceLimits.maxRequestBytes) {
+        reply(errorReply(QJsonValue(QJsonValue::Undefined), "too-large",
+            QString("la peticion supera %1 bytes").arg(serviceLimits.maxRequestBytes)));
+        return;
+    }
+
+    auto job = std::make_unique<Job>();
+    job->request = line;
+    job->received = Clock::now();
+    job->reply = std::move(reply);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const char* rejected = nullptr;
+        if (stopping) rejected = "shutdown";
+        else if (int(queue.size()) >= serviceLimits.maxPending) rejected = "busy";
+
+        if (rejected) {
+            lock.unlock();
+            // Solo al rechazar se lee el JSON en este hilo, para devolver el "id"
+            job->reply(errorReply(requestId(job->request), rejected, "la peticion no se encolo"));
+            return;
+        }
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ConversionService::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && active == 0; });
+}
+
+// ==================== HILOS DE TRABAJO ====================
+
+void ConversionService::loop()
+{
+    for (;;) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            ++active;
+        }
+
+        job->reply(process(*job));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+        }
+        idle.notify_all();
+    }
+}
+
+// Valida la petición y la convierte; devuelve la línea de respuesta
+QByteArray ConversionService::process(const Job& job)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(job.request, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        return errorReply(QJsonValue(QJsonValue::Undefined), "bad-request", "se esperaba un objeto JSON por linea");
+    }
+
+    const QJsonObject request = document.object();
+    const QJsonValue id = request.value("id");
+
+    const QJsonValue sourceValue = request.value("source");
+    if (!sourceValue.isString()) {
+        return errorReply(id, "bad-request", "falta el campo \"source\"");
+    }
+    const std::string source = sourceValue.toString().toStdString();
+
+    const int depth = nestingDepth(source);
+    if (depth > serviceLimits.maxNestingDepth) {
+        return errorReply(id, "too-deep",
+            QString("%1 niveles de anidamiento (maximo %2)").arg(depth).arg(serviceLimits.maxNestingDepth));
+    }
+
+    int timeoutMs = request.value("timeout_ms").toInt(serviceLimits.defaultTimeoutMs);
+    if (timeoutMs <= 0) timeoutMs = serviceLimits.defaultTimeoutMs;
+    timeoutMs = qMin(timeoutMs, serviceLimits.maxTimeoutMs);
+    const Clock::time_point at = job.received + std::chrono::milliseconds(timeoutMs);
+    if (Clock::now() >= at) {
+        return errorReply(id, "timeout", "el plazo vencio en la cola");
+    }
+
+    Deadline deadline(at);
+    const std::string code = converter->convert(source, deadline);
+    if (deadline.fired()) {
+        return errorReply(id, "timeout", "el plazo vencio durante la conversion");
+    }
+
+    QJsonObject object;
+    if (!id.isUndefined()) object.insert("id", id);
+    object.insert("ok", true);
+    object.insert("code", QString::fromStdString(code));
+    return toLine(object);
+}
+
+// ==================== UTILIDADES ====================
+
+// "id" de una petición sin validar; indefinido si no se puede leer
+QJsonValue ConversionService::requestId(const QByteArray& line)
+{
+    const QJsonDocument document = QJsonDocument::fromJson(line);
+    if (!document.isObject()) return QJsonValue(QJsonValue::Undefined);
+    return document.object().value("id");
+}
+
+int ConversionService::nestingDepth(std::string_view source)
+{
+    StringLineReader reader(source);
+    std::string_view raw;
+    LexedLine lexed;
+    int depth = 0;
+    int deepest = 0;
+
+    while (reader.readLine(raw)) {
+        Lexer::lex(raw, lexed);
+        if (lexed.tokens.empty()) continue;
+
+        switch (KeywordTable::match(lexed.text).phrase) {
+        case Phrase::Si:
+        case Phrase::Mientras:
+        case Phrase::Para:
+        case Phrase::Repetir:
+        case Phrase::RepetirHasta:
+        case Phrase::DefinirFuncion:
+            deepest = qMax(deepest, ++depth);
+            break;
+        case Phrase::FinSi:
+        case Phrase::FinMientras:
+        case Phrase::FinPara:
+        case Phrase::Hasta:
+        case Phrase::HastaQue:
+        case Phrase::FinFuncion:
+            if (depth > 0) --depth;
+            break;
+        default:
+            break;
+        }
+    }
+    return deepest;
+}
+
+QByteArray ConversionService::errorReply(const QJsonValue& id, const char* error, const QString& message)
+{
+    QJsonObject object;
+    if (!id.isUndefined()) object.insert("id", id);
+    object.insert("ok", false);
+    object.insert("error", QString::fromLatin1(error));
+    object.insert("message", message);
+    return toLine(object);
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QJsonValue>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class ConversionCache;
+class Converter;
+
+// Límites que el servicio aplica a cada petición antes y durante la conversión
+struct ServiceLimits {
+    qsizetype maxRequestBytes = 8 * 1024 * 1024;   // línea JSON completa
+    int maxNestingDepth = 256;                     // bloques si/mientras/para/... abiertos a la vez
+    int defaultTimeoutMs = 10000;                  // si la petición no trae "timeout_ms"
+    int maxTimeoutMs = 60000;
+    int maxPending = 1024;                         // peticiones en cola; más allá se rechaza
+};
+
+// Servicio de conversión de larga duración. Los hilos de trabajo comparten un
+// Converter cuyos espacios de trabajo quedan "calientes" entre peticiones, así
+// una conversión no paga el arranque del proceso ni de Qt.
+//
+// Protocolo (JSON por líneas, una petición y una respuesta por línea):
+//   -> {"id": 7, "source": "comenzar programa\n...", "timeout_ms": 2000}
+//   <- {"id": 7, "ok": true, "code": "#include <iostream>\n..."}
+//   <- {"id": 7, "ok": false, "error": "timeout", "message": "..."}
+// "id" es opcional y se devuelve tal cual; la respuesta no lo lleva si la
+// petición no se pudo leer ("bad-request" por JSON inválido, "too-large").
+// Errores posibles: "bad-request", "too-large", "too-deep", "busy", "timeout"
+// y "shutdown". En el socket local del daemon, una petición "too-large" cierra
+// la conexión después de responder las anteriores; las siguientes se descartan.
+//
+// Las respuestas se entregan en el orden en que terminan, no en el de llegada.
+class ConversionService
+{
+public:
+    using Reply = std::function<void(const QByteArray& line)>;
+
+    // workerCount <= 0 usa QThread::idealThreadCount()
+    explicit ConversionService(const ServiceLimits& limits = ServiceLimits(), int workerCount = 0,
+                               ConversionCache* cache = nullptr);
+    ~ConversionService();
+
+    ConversionService(const ConversionService&) = delete;
+    ConversionService& operator=(const ConversionService&) = delete;
+
+    // Atiende una línea de petición (sin el '\n'). Aquí solo se comprueba el
+    // tamaño y se encola: el JSON, el texto y el anidamiento se validan en un
+    // hilo de trabajo, así una petición grande no frena al hilo llamador.
+    // 'reply' recibe la línea de respuesta, sin '\n', desde un hilo de trabajo
+    // o, si la petición se rechaza de entrada ("too-large", "busy",
+    // "shutdown"), desde el hilo llamador antes de volver. Seguro entre hilos.
+    void handle(const QByteArray& line, Reply reply);
+
+    // Espera a que se respondan todas las peticiones aceptadas hasta ahora
+    void drain();
+
+    const ServiceLimits& limits() const { return serviceLimits; }
+    int workerCount() const { return int(threads.size()); }
+
+    // Profundidad máxima de bloques anidados de 'source', sin parsearla
+    static int nestingDepth(std::string_view source);
+
+    static QByteArray errorReply(const QJsonValue& id, const char* error, const QString& message);
+
+private:
+    struct Job;
+
+    void loop();
+    QByteArray process(const Job& job);
+    static QJsonValue requestId(const QByteArray& line);
+
+    ServiceLimits serviceLimits;
+    std::unique_ptr<Converter> converter;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<std::unique_ptr<Job>> queue;
+    int active = 0;
+    bool stopping = false;
+
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,88 @@
+﻿#include "stdafx.h"
+#include "conversion_stats.h"
+
+namespace {
+// Con dos decimales y sin depender del locale (printf usaría la coma decimal)
+std::string milliseconds(std::int64_t ns)
+{
+    const std::int64_t hundredths = (ns + 5000) / 10000;
+    const int fraction = int(hundredths % 100);
+    return std::to_string(hundredths / 100) + (fraction < 10 ? ".0" : ".") + std::to_string(fraction) + " ms";
+}
+
+std::string number(std::int64_t n) { return std::to_string(n); }
+}
+
+// ==================== ACUMULACIÓN ====================
+
+std::int64_t ConversionStats::totalInstructions() const
+{
+    std::int64_t total = 0;
+    for (std::int64_t count : instructions) total += count;
+    return total;
+}
+
+void ConversionStats::merge(const ConversionStats& other)
+{
+    normalizeNs += other.normalizeNs;
+    parseNs += other.parseNs;
+    symbolsNs += other.symbolsNs;
+    generateNs += other.generateNs;
+
+    conversions += other.conversions;
+    cacheHits += other.cacheHits;
+    lines += other.lines;
+    for (int i = 0; i < instructionTypeCount; ++i) instructions[i] += other.instructions[i];
+    errorEmissions += other.errorEmissions;
+    outputSize += other.outputSize;
+}
+
+// ==================== TEXTO ====================
+
+const char* ConversionStats::typeName(InstructionType type)
+{
+    switch (type) {
+    case InstructionType::Arithmetic:           return "aritmetica";
+    case InstructionType::VariableDeclaration:  return "declaracion";
+    case InstructionType::Assignment:           return "asignacion";
+    case InstructionType::ArrayCreation:        return "lista";
+    case InstructionType::ControlStructure:     return "control";
+    case InstructionType::Input:                return "entrada";
+    case InstructionType::Output:               return "salida";
+    case InstructionType::FunctionDefinition:   return "definicion de funcion";
+    case InstructionType::FunctionCall:         return "llamada";
+    case InstructionType::Unknown:              return "desconocida";
+    case InstructionType::FunctionDeclaration:  return "declaracion de funcion";
+    case InstructionType::ProgramStart:         return "inicio de programa";
+    case InstructionType::ProgramEnd:           return "fin de programa";
+    }
+    return "?";
+}
+
+std::string ConversionStats::summary() const
+{
+    return number(lines) + " lineas, " +
+           number(totalInstructions()) + " instrucciones (" +
+           number(unknownInstructions()) + " desconocidas), " +
+           number(errorEmissions) + " errores, " +
+           number(outputSize) + " bytes en " + milliseconds(totalNs());
+}
+
+std::string ConversionStats::report() const
+{
+    std::string text;
+    text += "conversiones: " + number(conversions);
+    if (cacheHits > 0) text += " (" + number(cacheHits) + " desde la cache)";
+    text += "\nnormalizacion: " + milliseconds(normalizeNs);
+    text += "\nparseo: " + milliseconds(parseNs);
+    text += "\nsimbolos: " + milliseconds(symbolsNs);
+    text += "\ngeneracion: " + milliseconds(generateNs);
+    text += "\nlineas: " + number(lines);
+    for (int i = 0; i < instructionTypeCount; ++i) {
+        if (instructions[i] == 0) continue;
+        text += std::string("\n  ") + typeName(InstructionType(i)) + ": " + number(instructions[i]);
+    }
+    text += "\nerrores emitidos: " + number(errorEmissions);
+    text += "\nbytes generados: " + number(outputSize);
+    return text;
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "natural_language_processor.h"
+
+constexpr int instructionTypeCount = int(InstructionType::ProgramEnd) + 1;
+
+// Métricas por etapa de una o varias conversiones. Se activan pasando un
+// registro a Converter::setStats (y a las etapas); sin registro no se toma
+// ningún tiempo ni se cuenta nada. Cada conversión suma a lo que ya había,
+// así un mismo registro acumula un lote completo.
+struct ConversionStats {
+    // Tiempo de pared por etapa, en nanosegundos
+    std::int64_t normalizeNs = 0;   // lexer: normalización y tokenizado de cada línea
+    std::int64_t parseNs = 0;       // parser, sin el lexer
+    std::int64_t symbolsNs = 0;     // recolección de símbolos del generador
+    std::int64_t generateNs = 0;    // escritura del código C++
+
+    int conversions = 0;
+    int cacheHits = 0;              // conversiones resueltas por ConversionCache (sin etapas)
+    std::int64_t lines = 0;         // líneas leídas, incluidas las vacías
+    std::array<std::int64_t, instructionTypeCount> instructions{};  // por InstructionType, con las anidadas
+    std::int64_t errorEmissions = 0;    // comentarios "// Error:" escritos
+    std::int64_t outputSize = 0;        // bytes generados (UTF-8)
+
+    std::int64_t unknownInstructions() const { return instructions[int(InstructionType::Unknown)]; }
+    std::int64_t totalInstructions() const;
+    std::int64_t totalNs() const { return normalizeNs + parseNs + symbolsNs + generateNs; }
+
+    void merge(const ConversionStats& other);
+    void clear() { *this = ConversionStats(); }
+
+    // Resumen de una línea (barra de estado, CLI)
+    std::string summary() const;
+    // Detalle con los tiempos por etapa y las instrucciones por tipo
+    std::string report() const;
+
+    static const char* typeName(InstructionType type);
+
+    // Reloj de las mediciones
+    static std::int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
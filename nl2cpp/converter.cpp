@@ -1,5 +1,106 @@
 #include "stdafx.h"
 #include "converter.h"
+#include "conversion_stats.h"
+#include "line_reader.h"
+#include <iterator>
+
+namespace {
+// Con cach hace falta la entrada completa para calcular la clave
+std::string readWhole(std::istream& input)
+{
+    return std::string{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+std::string readWhole(LineReader& input)
+{
+    std::string text;
+    std::string_view line;
+    while (input.readLine(line)) {
+        text += line;
+        text += '\n';
+    }
+    return text;
+}
+
+// Reenva a otro sink contando los bytes (solo con mtricas activas)
+class CountingSink : public CodeSink
+{
+public:
+    explicit CountingSink(CodeSink& target) : target(target) {}
+
+    void write(std::string_view text) override
+    {
+        written += text.size();
+        target.write(text);
+    }
+    bool flush() override { return target.flush(); }
+
+    std::size_t written = 0;
+
+private:
+    CodeSink& target;
+};
+}
+
+// ==================== ESPACIOS DE TRABAJO ====================
+
+// Todo lo que una conversin modifica. Nunca lo usan dos llamadas a la vez.
+struct Converter::Workspace {
+    NaturalLanguageProcessor processor;
+    CodeGenerator generator;
+    Program program;            // rbol de la ltima conversin; se vaca en la siguiente
+    std::string batchOutput;    // salida reutilizada por convertBatch con generador
+    ConversionStats stats;      // mtricas de la llamada en curso
+    ConversionStats* activeStats = nullptr;
+    ConversionObserver* observer = nullptr;
+};
+
+// Toma un espacio de trabajo del pool (o crea uno), lo configura para la
+// llamada y, al salir de mbito, suma sus mtricas y lo devuelve al pool.
+class Converter::Lease
+{
+public:
+    Lease(const Converter& owner, ConversionObserver* callObserver = nullptr)
+        : owner(owner)
+    {
+        {
+            std::lock_guard<std::mutex> lock(owner.mutex);
+            if (!owner.idle.empty()) {
+                workspace = std::move(owner.idle.back());
+                owner.idle.pop_back();
+            }
+        }
+        if (!workspace) workspace = std::make_unique<Workspace>();
+
+        Workspace& ws = *workspace;
+        ws.observer = callObserver ? callObserver : owner.observer;
+        ws.activeStats = owner.stats ? &ws.stats : nullptr;
+        ws.processor.setObserver(ws.observer);
+        ws.processor.setStats(ws.activeStats);
+        ws.generator.setObserver(ws.observer);
+        ws.generator.setStats(ws.activeStats);
+        ws.generator.setThreadCount(owner.threadCount);
+    }
+
+    ~Lease()
+    {
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        if (owner.stats) {
+            owner.stats->merge(workspace->stats);
+            workspace->stats.clear();
+        }
+        owner.idle.push_back(std::move(workspace));
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    Workspace& operator*() const { return *workspace; }
+
+private:
+    const Converter& owner;
+    std::unique_ptr<Workspace> workspace;
+};
 
 // ==================== CONSTRUCTOR ====================
 Converter::Converter() {}
@@ -8,13 +109,217 @@ Converter::~Converter() {}
 
 // ==================== MTODO PRINCIPAL ====================
 
-QString Converter::convert(const QString& inputText)
+std::string Converter::convert(std::string_view inputText) const
+{
+    Lease ws(*this);
+    return convertText(*ws, inputText);
+}
+
+std::string Converter::convert(std::string_view inputText, ConversionObserver& callObserver) const
 {
+    Lease ws(*this, &callObserver);
+    return convertText(*ws, inputText);
+}
+
+std::string Converter::convert(std::istream& input) const
+{
+    Lease ws(*this);
+    if (cache) return convertText(*ws, readWhole(input));
+
+    StdStreamLineReader reader(input);
+    parse(*ws, reader);
+    return generate(*ws);
+}
+
+std::string Converter::convert(LineReader& input) const
+{
+    Lease ws(*this);
+    return convertReader(*ws, input);
+}
+
+void Converter::convert(std::string_view inputText, CodeSink& output) const
+{
+    Lease ws(*this);
+    if (cache) {
+        output << convertText(*ws, inputText);
+        return;
+    }
+
+    StringLineReader reader(inputText);
+    parse(*ws, reader);
+    generate(*ws, output);
+}
+
+void Converter::convert(std::istream& input, CodeSink& output) const
+{
+    Lease ws(*this);
+    if (cache) {
+        output << convertText(*ws, readWhole(input));
+        return;
+    }
+
+    StdStreamLineReader reader(input);
+    parse(*ws, reader);
+    generate(*ws, output);
+}
+
+void Converter::convert(LineReader& input, CodeSink& output) const
+{
+    Lease ws(*this);
+    if (cache) {
+        output << convertReader(*ws, input);
+        return;
+    }
+
+    parse(*ws, input);
+    generate(*ws, output);
+}
+
+std::string Converter::convertText(Workspace& ws, std::string_view inputText) const
+{
+    StringLineReader reader(inputText);
+    if (cache) return convertKeyed(ws, reader, OutputCache::keyFor(inputText, outputFingerprint()));
+
     // 1. Procesar el texto natural en instrucciones
-    std::vector<Instruction> instructions = processor.processText(inputText);
+    parse(ws, reader);
 
     // 2. Generar el cdigo C++ a partir de esas instrucciones
-    QString generatedCode = generator.generateCode(instructions);
+    return generate(ws);
+}
+
+// Con cach, una fuente que se puede releer (archivo proyectado) se lee dos
+// veces, para la clave y para el parseo, en lugar de copiarla entera
+std::string Converter::convertReader(Workspace& ws, LineReader& input) const
+{
+    if (!cache) {
+        parse(ws, input);
+        return generate(ws);
+    }
+
+    if (!input.rewind()) return convertText(ws, readWhole(input));
+
+    const CacheKey key = OutputCache::keyFor(input, outputFingerprint());
+    input.rewind();
+    return convertKeyed(ws, input, key);
+}
+
+void Converter::setObserver(ConversionObserver* conversionObserver)
+{
+    observer = conversionObserver;
+}
+
+// ==================== CACH ====================
+
+void Converter::setCache(OutputCache* conversionCache)
+{
+    cache = conversionCache;
+}
+
+std::uint64_t Converter::outputFingerprint() const
+{
+    // Todava no hay opciones de salida: basta la versin del generador
+    return std::uint64_t(CodeGenerator::outputVersion);
+}
+
+std::string Converter::convert(std::string_view inputText, const CacheKey& key) const
+{
+    Lease ws(*this);
+    StringLineReader reader(inputText);
+    return convertKeyed(*ws, reader, key);
+}
+
+std::string Converter::convert(LineReader& input, const CacheKey& key) const
+{
+    Lease ws(*this);
+    return convertKeyed(*ws, input, key);
+}
+
+std::string Converter::convertKeyed(Workspace& ws, LineReader& input, const CacheKey& key) const
+{
+    std::string output;
+    if (cache && cache->lookup(key, output)) {
+        if (ws.activeStats) {
+            ++ws.activeStats->conversions;
+            ++ws.activeStats->cacheHits;
+            ws.activeStats->outputSize += std::int64_t(output.size());
+        }
+        return output;
+    }
+
+    parse(ws, input);
+    output = generate(ws);
+
+    // Una conversin cancelada est incompleta: no se guarda
+    if (cache && !(ws.observer && ws.observer->isCancelled())) cache->store(key, output);
+    return output;
+}
+
+// ==================== LOTES ====================
+
+void Converter::convertBatch(const std::vector<std::string>& inputs, std::vector<std::string>& outputs) const
+{
+    Lease ws(*this);
+    outputs.resize(inputs.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i) convertInto(*ws, inputs[i], outputs[i]);
+}
+
+void Converter::convertBatch(const BatchSource& next, const BatchSink& onOutput) const
+{
+    Lease ws(*this);
+    std::string_view input;
+    for (std::size_t index = 0; next(input); ++index) {
+        convertInto(*ws, input, (*ws).batchOutput);
+        onOutput(index, (*ws).batchOutput);
+    }
+}
+
+void Converter::convertInto(Workspace& ws, std::string_view input, std::string& output) const
+{
+    output.clear();         // conserva la capacidad de la salida anterior
+    StringLineReader reader(input);
+
+    if (cache) {
+        output = convertKeyed(ws, reader, OutputCache::keyFor(input, outputFingerprint()));
+        return;
+    }
+
+    const Program& parsed = parse(ws, reader);
+    StringSink sink(output, CodeGenerator::estimateSize(parsed));
+    generate(ws, sink);
+}
+
+const Program& Converter::parse(Workspace& ws, LineReader& input)
+{
+    ws.processor.processLines(input, ws.program);
+    return ws.program;
+}
+
+// ==================== MTRICAS ====================
+
+void Converter::setStats(ConversionStats* conversionStats)
+{
+    stats = conversionStats;
+}
+
+std::string Converter::generate(Workspace& ws)
+{
+    std::string code = ws.generator.generateCode(ws.program);
+    if (ws.activeStats) {
+        ++ws.activeStats->conversions;
+        ws.activeStats->outputSize += std::int64_t(code.size());
+    }
+    return code;
+}
+
+void Converter::generate(Workspace& ws, CodeSink& output)
+{
+    if (!ws.activeStats) {
+        ws.generator.generateCode(ws.program, output);
+        return;
+    }
 
-    return generatedCode;
+    CountingSink counted(output);
+    ws.generator.generateCode(ws.program, counted);
+    ++ws.activeStats->conversions;
+    ws.activeStats->outputSize += std::int64_t(counted.written);
 }
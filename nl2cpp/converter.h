@@ -1,19 +1,114 @@
 #pragma once
 
-#include <QString>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "natural_language_processor.h"
 #include "code_generator.h"
+#include "output_cache.h"
 
+// Conversor NL -> C++ sobre texto UTF-8, sin dependencias de Qt (las
+// aplicaciones Qt lo usan a travs de QtAdapter). Una vez configurado
+// (setCache, setStats, setObserver, setThreadCount) es inmutable: todos los
+// convert() son const y seguros entre hilos, as un nico Converter compartido
+// atiende a cualquier nmero de llamadores a la vez. El estado de cada
+// conversin (parser, generador, rbol y buffers) vive en un espacio de trabajo
+// que la llamada toma de un pool interno y devuelve al terminar, de modo que se
+// reutiliza sin compartirse.
+//
+// Los setters no son seguros frente a conversiones en curso: se llaman antes
+// de compartir el Converter.
 class Converter
 {
 public:
     Converter();
     ~Converter();
 
+    Converter(const Converter&) = delete;
+    Converter& operator=(const Converter&) = delete;
+
     // Punto de entrada principal: convierte texto NL -> C++
-    QString convert(const QString& inputText);
+    std::string convert(std::string_view inputText) const;
+
+    // Igual, con un observador de avance y cancelacin solo para esta llamada
+    std::string convert(std::string_view inputText, ConversionObserver& callObserver) const;
+
+    // Convierte leyendo la entrada lnea a lnea (archivos grandes, tuberas)
+    std::string convert(std::istream& input) const;
+    std::string convert(LineReader& input) const;
+
+    // Escriben el resultado directamente en 'output' (memoria, archivo, tubera...)
+    void convert(std::string_view inputText, CodeSink& output) const;
+    void convert(std::istream& input, CodeSink& output) const;
+    void convert(LineReader& input, CodeSink& output) const;
+
+    // Convierte un lote reutilizando entre entradas el programa parseado, los
+    // buffers de lnea y la capacidad de las salidas: una vez caliente, convertir
+    // fragmentos pequeos casi no reserva memoria. outputs[i] corresponde a inputs[i].
+    void convertBatch(const std::vector<std::string>& inputs, std::vector<std::string>& outputs) const;
+
+    // Variante con generador: 'next' entrega cada entrada (false al terminar) y
+    // 'onOutput' recibe su salida en un buffer reutilizado, vlido solo durante la llamada
+    using BatchSource = std::function<bool(std::string_view& input)>;
+    using BatchSink = std::function<void(std::size_t index, const std::string& output)>;
+    void convertBatch(const BatchSource& next, const BatchSink& onOutput) const;
+
+    // Observador por defecto de las conversiones sin observador propio (nullptr = ninguno).
+    // Si cancela, la salida devuelta est incompleta y debe descartarse.
+    void setObserver(ConversionObserver* observer);
+
+    // Hilos para generar las definiciones de funciones (0 = automtico, 1 = en serie)
+    void setThreadCount(int threads) { threadCount = threads; }
+
+    // Cach opcional (nullptr = desactivada). En un acierto se devuelve la salida
+    // guardada sin parsear ni generar. Con cach, una entrada que no se puede
+    // releer (stream, LineReader sin rewind) se lee completa antes de convertir.
+    void setCache(OutputCache* cache);
+
+    // Igual que convert(inputText), con la clave de cach ya calculada por el llamador
+    std::string convert(std::string_view inputText, const CacheKey& key) const;
+
+    // Igual, leyendo de 'input' desde su principio (por ejemplo un MappedLineReader)
+    std::string convert(LineReader& input, const CacheKey& key) const;
+
+    // Versin del generador y opciones que afectan la salida (parte de la clave de cach)
+    std::uint64_t outputFingerprint() const;
+
+    // Registro donde se suman las mtricas de cada conversin (nullptr = desactivadas,
+    // sin costo). Cada llamada mide en su espacio de trabajo y suma al registro al
+    // terminar, bajo un mutex: las llamadas concurrentes pueden compartirlo.
+    void setStats(ConversionStats* stats);
 
 private:
-    NaturalLanguageProcessor processor;
-    CodeGenerator generator;
+    struct Workspace;
+    class Lease;
+
+    // Implementaciones sobre el espacio de trabajo de la llamada
+    std::string convertText(Workspace& ws, std::string_view inputText) const;
+    std::string convertReader(Workspace& ws, LineReader& input) const;
+    std::string convertKeyed(Workspace& ws, LineReader& input, const CacheKey& key) const;
+
+    // Escribe en 'output' la conversin de 'input', conservando su capacidad
+    void convertInto(Workspace& ws, std::string_view input, std::string& output) const;
+
+    // Parsea en el programa del espacio de trabajo, reutilizando su memoria
+    static const Program& parse(Workspace& ws, LineReader& input);
+
+    // Generacin comn a todas las variantes de convert(): suma a las mtricas
+    static std::string generate(Workspace& ws);
+    static void generate(Workspace& ws, CodeSink& output);
+
+    OutputCache* cache = nullptr;
+    ConversionObserver* observer = nullptr;
+    ConversionStats* stats = nullptr;
+    int threadCount = 0;
+
+    // Espacios de trabajo libres; 'mutex' protege el pool y la suma de mtricas
+    mutable std::mutex mutex;
+    mutable std::vector<std::unique_ptr<Workspace>> idle;
 };
@@ -0,0 +1,151 @@
+﻿#include "stdafx.h"
+#include "corpus_generator.h"
+
+#include <random>
+
+namespace {
+
+const char* const typeNames[] = { "entero", "decimal", "texto" };
+
+const char* const comparisons[] = { "mayor que", "menor que", "igual a", "diferente de" };
+
+const char16_t* const words[] = {
+    u"hola", u"mundo", u"valor", u"resultado", u"Número", u"listo", u"error", u"fin",
+    u"cálculo", u"total", u"dato", u"ejemplo"
+};
+
+QString number(int n) { return QString::number(n); }
+
+class Writer
+{
+public:
+    Writer(const CorpusOptions& options) : options(options), random(options.seed)
+    {
+        text.reserve(qsizetype(options.lines) * 24);
+    }
+
+    QString run()
+    {
+        line(0, "comenzar programa");
+
+        const int variables = qMax(1, options.variables);
+        for (int v = 0; v < variables; ++v) {
+            line(0, QString("crear variable ") + typeNames[v % 3] + " v" + number(v));
+        }
+
+        // Cada función ocupa una porción pequeña del presupuesto de líneas
+        for (int f = 0; f < options.functions; ++f) {
+            line(0, "definir funcion f" + number(f));
+            const int body = 1 + pick(4);
+            for (int s = 0; s < body; ++s) simpleStatement(1);
+            line(0, "fin funcion");
+        }
+
+        while (written < options.lines - 1) statement(0);
+
+        line(0, "terminar programa");
+        return text;
+    }
+
+private:
+    int pick(int n) { return int(random() % std::uint32_t(n)); }
+    bool chance(double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(random) < p; }
+
+    QString variable() { return QChar('v') + number(pick(qMax(1, options.variables))); }
+
+    QString literal()
+    {
+        QString s(u'"');
+        const int count = 1 + pick(4);
+        for (int i = 0; i < count; ++i) {
+            if (i) s += ' ';
+            s += QStringView(words[pick(int(sizeof(words) / sizeof(words[0])))]);
+        }
+        return s + '"';
+    }
+
+    QString condition()
+    {
+        return variable() + ' ' + comparisons[pick(4)] + ' ' + number(pick(100));
+    }
+
+    void line(int depth, const QString& content)
+    {
+        text += QString(depth * 2, ' ');
+        text += content;
+        text += '\n';
+        ++written;
+    }
+
+    void simpleStatement(int depth)
+    {
+        switch (pick(7)) {
+        case 0: line(depth, "asignar " + variable() + " = " + variable() + " + " + number(pick(10))); break;
+        case 1: line(depth, "sumar " + variable() + " y " + number(pick(10))); break;
+        case 2: line(depth, "restar " + variable() + " con " + number(pick(10))); break;
+        case 3: line(depth, "leer " + variable()); break;
+        case 4:
+            if (options.functions > 0) {
+                line(depth, "llamar funcion f" + number(pick(options.functions)));
+                break;
+            }
+            Q_FALLTHROUGH();
+        default:
+            line(depth, "mostrar " + (chance(options.stringDensity) ? literal() : variable()));
+            break;
+        }
+    }
+
+    void block(int depth)
+    {
+        const int body = 1 + pick(4);
+        auto nested = [&] { for (int s = 0; s < body; ++s) statement(depth + 1); };
+
+        switch (pick(4)) {
+        case 0:
+            line(depth, "si " + condition());
+            nested();
+            if (chance(0.5)) {
+                line(depth, "sino");
+                nested();
+            }
+            line(depth, "fin si");
+            break;
+        case 1:
+            line(depth, "mientras " + condition());
+            nested();
+            line(depth, "fin mientras");
+            break;
+        case 2:
+            line(depth, "para i" + number(depth) + " desde 0 hasta " + number(1 + pick(20)));
+            nested();
+            line(depth, "fin para");
+            break;
+        default:
+            line(depth, "repetir");
+            nested();
+            line(depth, "hasta que " + condition());
+            break;
+        }
+    }
+
+    void statement(int depth)
+    {
+        if (depth < options.maxDepth && chance(0.25)) block(depth);
+        else simpleStatement(depth);
+    }
+
+    const CorpusOptions& options;
+    std::mt19937 random;
+    QString text;
+    int written = 0;
+};
+
+} // namespace
+
+// ==================== GENERACIÓN ====================
+
+QString CorpusGenerator::generate(const CorpusOptions& options)
+{
+    return Writer(options).run();
+}
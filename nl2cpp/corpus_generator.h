@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include <QString>
+#include <cstdint>
+
+// Parámetros de un programa sintético en pseudocódigo
+struct CorpusOptions {
+    int lines = 10000;              // tamaño aproximado en líneas
+    int maxDepth = 3;               // anidamiento máximo de bloques
+    int functions = 20;             // funciones definidas (y llamadas desde el cuerpo)
+    double stringDensity = 0.3;     // fracción de 'mostrar' con un literal entre comillas
+    int variables = 20;             // variables declaradas al inicio
+    std::uint32_t seed = 1;         // misma semilla = mismo programa
+};
+
+// Genera programas válidos para el conversor: declaraciones, definiciones de
+// funciones y un cuerpo con si/sino, mientras, para y repetir anidados. Se usa
+// en los benchmarks para medir cómo escala cada etapa.
+class CorpusGenerator
+{
+public:
+    static QString generate(const CorpusOptions& options);
+};
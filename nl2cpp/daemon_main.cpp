@@ -0,0 +1,331 @@
+﻿#include "stdafx.h"
+#include "conversion_cache.h"
+#include "conversion_service.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTextStream>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// ==================== SOCKET LOCAL ====================
+
+// Acepta conexiones en un socket local (Unix o tubería con nombre en Windows).
+// Cada conexión puede tener varias peticiones en vuelo; las respuestas vuelven
+// desde los hilos de trabajo al hilo principal por una llamada encolada.
+// Una petición demasiado grande no se termina de recibir: se responde
+// "too-large" (sin "id"), se deja de leer y la conexión se cierra cuando
+// se han respondido las peticiones anteriores.
+class SocketFrontend : public QObject
+{
+public:
+    explicit SocketFrontend(qsizetype maxRequestBytes) : maxRequestBytes(maxRequestBytes) {}
+
+    void setService(ConversionService* conversionService) { service = conversionService; }
+
+    bool listen(const QString& name, QString* error)
+    {
+        QLocalServer::removeServer(name);       // socket huérfano de una ejecución anterior
+        connect(&server, &QLocalServer::newConnection, this, &SocketFrontend::accept);
+        if (server.listen(name)) return true;
+        *error = server.errorString();
+        return false;
+    }
+
+    QString fullServerName() const { return server.fullServerName(); }
+
+private:
+    void accept()
+    {
+        while (QLocalSocket* socket = server.nextPendingConnection()) {
+            const quint64 id = nextConnection++;
+            connections.insert(id, Connection{ socket });
+            connect(socket, &QLocalSocket::readyRead, this, [this, id, socket] { read(id, socket); });
+            connect(socket, &QLocalSocket::disconnected, this, [this, id, socket] {
+                connections.remove(id);
+                socket->deleteLater();
+            });
+        }
+    }
+
+    void read(quint64 id, QLocalSocket* socket)
+    {
+        const auto connection = connections.find(id);
+        if (connection == connections.end()) return;
+        if (connection->closing) {
+            socket->readAll();
+            return;
+        }
+
+        while (socket->canReadLine()) {
+            QByteArray line = socket->readLine();
+            line.chop(1);
+            if (line.endsWith('\r')) line.chop(1);
+            if (line.trimmed().isEmpty()) continue;
+            ++connection->pending;
+            service->handle(line, [this, id](const QByteArray& response) { post(id, response); });
+        }
+
+        // Una línea a medias que ya supera el límite no se termina de recibir
+        if (socket->bytesAvailable() > maxRequestBytes) {
+            socket->write(ConversionService::errorReply(QJsonValue(QJsonValue::Undefined), "too-large",
+                QString("la peticion supera %1 bytes").arg(maxRequestBytes)) + '\n');
+            socket->readAll();
+            connection->closing = true;
+            if (connection->pending == 0) socket->disconnectFromServer();
+        }
+    }
+
+    // Llamado desde cualquier hilo: la escritura ocurre en el hilo del frontend.
+    // Si la conexión ya se cerró, la respuesta se descarta.
+    void post(quint64 id, const QByteArray& response)
+    {
+        QMetaObject::invokeMethod(this, [this, id, response] {
+            const auto connection = connections.find(id);
+            if (connection == connections.end()) return;
+            connection->socket->write(response + '\n');
+            if (--connection->pending == 0 && connection->closing) connection->socket->disconnectFromServer();
+        }, Qt::QueuedConnection);
+    }
+
+    struct Connection {
+        QLocalSocket* socket = nullptr;
+        int pending = 0;        // peticiones aceptadas aún sin responder
+        bool closing = false;   // llegó una petición demasiado grande: no se lee más
+    };
+
+    QLocalServer server;
+    QHash<quint64, Connection> connections;
+    quint64 nextConnection = 1;
+    qsizetype maxRequestBytes;
+    ConversionService* service = nullptr;
+};
+
+// ==================== ENTRADA/SALIDA ESTÁNDAR ====================
+
+// Una petición por línea de stdin, una respuesta por línea de stdout.
+// Devuelve al llegar al final de la entrada y responder todo lo pendiente.
+void serveStdio(ConversionService& service)
+{
+    std::mutex outputMutex;
+    auto reply = [&outputMutex](const QByteArray& response) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fwrite(response.constData(), 1, std::size_t(response.size()), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    };
+
+    QFile input;
+    if (!input.open(stdin, QIODevice::ReadOnly)) return;
+
+    for (;;) {
+        QByteArray line = input.readLine(service.limits().maxRequestBytes + 2);
+        if (line.isEmpty()) break;
+
+        // Línea más larga que el límite: se rechaza y se descarta el resto
+        if (!line.endsWith('\n') && line.size() > service.limits().maxRequestBytes) {
+            reply(ConversionService::errorReply(QJsonValue(QJsonValue::Undefined), "too-large",
+                QString("la peticion supera %1 bytes").arg(service.limits().maxRequestBytes)));
+            while (!line.isEmpty() && !line.endsWith('\n')) line = input.readLine(64 * 1024);
+            continue;
+        }
+
+        while (line.endsWith('\n') || line.endsWith('\r')) line.chop(1);
+        if (line.trimmed().isEmpty()) continue;
+        service.handle(line, reply);
+    }
+    service.drain();
+}
+
+// ==================== CLIENTE ====================
+
+// Envía cada archivo (o stdin) como una petición, espera todas las respuestas
+// y escribe el código en el orden de las entradas. Sirve para probar el daemon.
+// Si el daemon cierra la conexión antes (petición demasiado grande), escribe
+// lo que ya llegó; la respuesta sin "id" se atribuye a la primera petición
+// sin responder, que es la que el daemon no terminó de leer.
+int runClient(const QString& name, const QStringList& paths, int timeoutMs)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (!socket.waitForConnected(5000)) {
+        err << "nl2cpp-daemon: no se pudo conectar a " << name << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+
+    const QStringList inputs = paths.isEmpty() ? QStringList{ "-" } : paths;
+    int failures = 0;
+    std::vector<int> sent;
+    for (int i = 0; i < inputs.size(); ++i) {
+        QFile file;
+        bool opened = false;
+        if (inputs[i] == "-") {
+            opened = file.open(stdin, QIODevice::ReadOnly);
+        }
+        else {
+            file.setFileName(inputs[i]);
+            opened = file.open(QIODevice::ReadOnly);
+        }
+        if (!opened) {
+            err << "nl2cpp-daemon: " << inputs[i] << ": " << file.errorString() << "\n";
+            ++failures;
+            continue;
+        }
+
+        QJsonObject request;
+        request.insert("id", i);
+        request.insert("source", QString::fromUtf8(file.readAll()));
+        if (timeoutMs > 0) request.insert("timeout_ms", timeoutMs);
+        socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+        sent.push_back(i);
+        while (socket.bytesToWrite() > 0 && socket.waitForBytesWritten(-1)) {}
+    }
+
+    // Las respuestas llegan en el orden en que terminan: se reordenan por id
+    std::map<int, QJsonObject> responses;
+    QJsonObject unmatched;      // respuesta sin "id"
+    while (responses.size() < sent.size()) {
+        if (!socket.canReadLine() && !socket.waitForReadyRead(-1)) {
+            err << "nl2cpp-daemon: conexion cerrada con " << int(sent.size() - responses.size())
+                << " peticiones sin responder\n";
+            break;
+        }
+        while (socket.canReadLine()) {
+            const QJsonObject response = QJsonDocument::fromJson(socket.readLine()).object();
+            const QJsonValue id = response.value("id");
+            if (id.isDouble()) responses[id.toInt()] = response;
+            else unmatched = response;
+        }
+    }
+
+    for (int id : sent) {
+        const QString& path = inputs[id];
+        QJsonObject response;
+        if (const auto found = responses.find(id); found != responses.end()) {
+            response = found->second;
+        }
+        else if (!unmatched.isEmpty()) {
+            response = unmatched;
+            unmatched = QJsonObject();
+        }
+        else {
+            err << "nl2cpp-daemon: " << path << ": sin respuesta\n";
+            ++failures;
+            continue;
+        }
+
+        if (!response.value("ok").toBool()) {
+            err << "nl2cpp-daemon: " << path << ": " << response.value("error").toString()
+                << ": " << response.value("message").toString() << "\n";
+            ++failures;
+            continue;
+        }
+        if (inputs.size() > 1) out << "// ==== " << path << "\n";
+        out << response.value("code").toString();
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Lee un entero positivo de una opción; false si no es válido
+bool positiveOption(const QCommandLineParser& parser, const QCommandLineOption& option, qint64& value)
+{
+    if (!parser.isSet(option)) return true;
+    bool ok = false;
+    value = parser.value(option).toLongLong(&ok);
+    return ok && value > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("nl2cpp-daemon");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Servicio de conversion de larga duracion: peticiones JSON por lineas sobre un socket local\n"
+        "o sobre stdin/stdout, atendidas por Converters reutilizados entre peticiones.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("entradas", "Con --client: archivos a enviar (por defecto, stdin).", "[entradas...]");
+
+    QCommandLineOption socketOption("socket", "Escucha en el socket local <nombre>.", "nombre", "nl2cpp");
+    QCommandLineOption stdioOption("stdio", "Atiende peticiones por stdin/stdout en lugar de un socket.");
+    QCommandLineOption clientOption("client", "Envia las entradas al daemon del socket <nombre> y muestra el resultado.", "nombre");
+    QCommandLineOption jobsOption({ "j", "jobs" }, "Numero de Converters en paralelo (por defecto, los nucleos).", "n");
+    QCommandLineOption maxBytesOption("max-bytes", "Tamano maximo de una peticion en bytes.", "n");
+    QCommandLineOption maxDepthOption("max-depth", "Anidamiento maximo de bloques.", "n");
+    QCommandLineOption timeoutOption("timeout", "Plazo por peticion en ms (por defecto 10000).", "ms");
+    QCommandLineOption cacheOption("cache", "Reutiliza conversiones guardadas en <dir>.", "dir");
+    parser.addOption(socketOption);
+    parser.addOption(stdioOption);
+    parser.addOption(clientOption);
+    parser.addOption(jobsOption);
+    parser.addOption(maxBytesOption);
+    parser.addOption(maxDepthOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(cacheOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    qint64 jobs = 0;
+    qint64 timeoutMs = 0;
+    ServiceLimits limits;
+    qint64 maxBytes = limits.maxRequestBytes;
+    qint64 maxDepth = limits.maxNestingDepth;
+    if (!positiveOption(parser, jobsOption, jobs) || !positiveOption(parser, maxBytesOption, maxBytes) ||
+        !positiveOption(parser, maxDepthOption, maxDepth) || !positiveOption(parser, timeoutOption, timeoutMs)) {
+        err << "nl2cpp-daemon: valor invalido en las opciones\n";
+        return 1;
+    }
+
+    if (parser.isSet(clientOption)) {
+        return runClient(parser.value(clientOption), parser.positionalArguments(), int(timeoutMs));
+    }
+
+    limits.maxRequestBytes = maxBytes;
+    limits.maxNestingDepth = int(qMin<qint64>(maxDepth, 1 << 20));
+    if (timeoutMs > 0) {
+        limits.defaultTimeoutMs = int(qMin<qint64>(timeoutMs, 1 << 30));
+        limits.maxTimeoutMs = qMax(limits.maxTimeoutMs, limits.defaultTimeoutMs);
+    }
+
+    std::unique_ptr<ConversionCache> cache;
+    if (parser.isSet(cacheOption)) cache = std::make_unique<ConversionCache>(parser.value(cacheOption));
+
+    // El frontend vive más que el servicio: las respuestas tardías aún encuentran a quién escribir
+    SocketFrontend frontend(limits.maxRequestBytes);
+    ConversionService service(limits, int(jobs), cache.get());
+
+    if (parser.isSet(stdioOption)) {
+        serveStdio(service);
+        return 0;
+    }
+
+    frontend.setService(&service);
+    QString error;
+    if (!frontend.listen(parser.value(socketOption), &error)) {
+        err << "nl2cpp-daemon: no se pudo escuchar en " << parser.value(socketOption) << ": " << error << "\n";
+        return 1;
+    }
+    err << "nl2cpp-daemon: escuchando en " << frontend.fullServerName() << " con "
+        << service.workerCount() << " hilos\n";
+    err.flush();
+
+    return app.exec();
+}
@@ -0,0 +1,27 @@
+﻿#include "stdafx.h"
+#include "emit_template.h"
+#include "code_sink.h"
+
+// ==================== PLANTILLAS ====================
+
+void EmitTemplate::emit(CodeSink& out, std::initializer_list<std::string_view> args) const
+{
+    for (int i = 0; i < segmentCount; ++i) {
+        const Segment& segment = segments[i];
+        if (segment.slot < 0) out.write(segment.literal);
+        else if (segment.slot < int(args.size())) out.write(args.begin()[segment.slot]);
+    }
+}
+
+// ==================== NÚMEROS ====================
+
+NumberText::NumberText(int number)
+{
+    // En unsigned para que INT_MIN no desborde al cambiar de signo
+    unsigned value = number < 0 ? 0u - unsigned(number) : unsigned(number);
+    do {
+        digits[--start] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (number < 0) digits[--start] = '-';
+}
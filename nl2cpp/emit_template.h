@@ -0,0 +1,77 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+
+class CodeSink;
+
+// Forma de salida de una construcción ("if ({0}) {\n", "{0} {1};"...),
+// compilada una sola vez en tramos literales y huecos numerados. Emitir solo
+// escribe los tramos precalculados y los argumentos en el sink, sin strings
+// temporales. Un '{' que no va seguido de dígito y '}' es literal.
+class EmitTemplate
+{
+public:
+    // 'pattern' debe vivir tanto como la plantilla (un literal "..."). Una
+    // plantilla constexpr se descompone durante la compilación y un patrón de
+    // más de maxSegments tramos es un error de compilación; fuera de una
+    // expresión constante, lanza std::length_error.
+    explicit constexpr EmitTemplate(const char* pattern);
+
+    void emit(CodeSink& out, std::initializer_list<std::string_view> args) const;
+
+private:
+    static constexpr int maxSegments = 16;
+
+    struct Segment {
+        std::string_view literal;
+        int slot = -1;          // -1: tramo literal
+    };
+
+    constexpr void addSegment(std::string_view literal, int slot);
+
+    Segment segments[maxSegments] = {};
+    int segmentCount = 0;
+};
+
+constexpr EmitTemplate::EmitTemplate(const char* pattern)
+{
+    const std::string_view text(pattern);
+    std::size_t literalStart = 0;
+
+    for (std::size_t i = 0; i + 2 < text.size(); ++i) {
+        const bool isSlot = text[i] == '{' && text[i + 1] >= '0' && text[i + 1] <= '9' && text[i + 2] == '}';
+        if (!isSlot) continue;
+
+        if (i > literalStart) addSegment(text.substr(literalStart, i - literalStart), -1);
+        addSegment({}, text[i + 1] - '0');
+        i += 2;
+        literalStart = i + 1;
+    }
+    if (literalStart < text.size()) addSegment(text.substr(literalStart), -1);
+}
+
+constexpr void EmitTemplate::addSegment(std::string_view literal, int slot)
+{
+    if (segmentCount == maxSegments) throw std::length_error("EmitTemplate: demasiados tramos en el patron");
+    segments[segmentCount].literal = literal;
+    segments[segmentCount].slot = slot;
+    ++segmentCount;
+}
+
+// Texto decimal de un entero en un buffer local (sin std::to_string)
+class NumberText
+{
+public:
+    explicit NumberText(int number);
+
+    std::string_view view() const { return std::string_view(digits + start, end - start); }
+    operator std::string_view() const { return view(); }
+
+private:
+    static constexpr std::size_t end = 12;
+    char digits[end];
+    std::size_t start = end;
+};
@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "interner.h"
+
+// Mapa SymbolId -> V con direccionamiento abierto y sondeo lineal, guardado en
+// un único arreglo. clear() es O(1): solo avanza la generación, así que la
+// capacidad se reutiliza entre conversiones sin volver a reservar memoria.
+template <typename V>
+class FlatMap
+{
+public:
+    V* find(SymbolId key) {
+        if (slots.empty() || key == NoSymbol) return nullptr;
+        Slot& s = slots[probe(key)];
+        return s.generation == generation ? &s.value : nullptr;
+    }
+    const V* find(SymbolId key) const { return const_cast<FlatMap*>(this)->find(key); }
+
+    bool contains(SymbolId key) const { return find(key) != nullptr; }
+
+    // Valor de 'key'; lo crea con V() si no existía
+    V& operator[](SymbolId key) {
+        if ((count + 1) * 2 > slots.size()) grow();
+
+        Slot& s = slots[probe(key)];
+        if (s.generation != generation) {
+            s.key = key;
+            s.generation = generation;
+            s.value = V();
+            ++count;
+        }
+        return s.value;
+    }
+
+    std::size_t size() const { return count; }
+
+    void clear() {
+        count = 0;
+        if (++generation == 0) {
+            // Vuelta completa del contador: invalidar todo explícitamente
+            for (Slot& s : slots) s.generation = 0;
+            generation = 1;
+        }
+    }
+
+private:
+    struct Slot {
+        SymbolId key = NoSymbol;
+        std::uint32_t generation = 0;   // ocupado si coincide con la generación actual
+        V value{};
+    };
+
+    // Mezcla multiplicativa: los SymbolId son densos y consecutivos
+    static std::size_t hashOf(SymbolId key) { return std::size_t(key * 2654435769u); }
+
+    // Ranura de 'key', o la primera libre de su secuencia de sondeo
+    std::size_t probe(SymbolId key) const {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = hashOf(key) & mask;
+        while (slots[i].generation == generation && slots[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.empty() ? 64 : old.size() * 2);
+
+        const std::uint32_t previous = generation;
+        generation = 1;
+        count = 0;
+        for (Slot& s : old) {
+            if (s.generation != previous) continue;
+            Slot& target = slots[probe(s.key)];
+            target.key = s.key;
+            target.generation = generation;
+            target.value = std::move(s.value);
+            ++count;
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::size_t count = 0;
+    std::uint32_t generation = 1;
+};
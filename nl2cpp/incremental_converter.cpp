@@ -0,0 +1,290 @@
+﻿#include "stdafx.h"
+#include "incremental_converter.h"
+#include "line_reader.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+// El interner solo crece mientras se escribe (cada prefijo de una palabra
+// nueva es otra palabra); pasado este tamaño se empieza de cero.
+constexpr std::size_t maxInternedWords = 1 << 16;
+
+// Cada pasada de parseo guarda sus unidades en un arena propio
+constexpr std::size_t passArenaSize = 16 * 1024;
+
+bool isLineStart(std::string_view text, std::size_t pos)
+{
+    return pos == 0 || text[pos - 1] == '\n';
+}
+
+int countLines(std::string_view text)
+{
+    return int(std::count(text.begin(), text.end(), '\n'));
+}
+}
+
+// ==================== CONSTRUCTOR ====================
+IncrementalConverter::IncrementalConverter() {}
+
+IncrementalConverter::~IncrementalConverter() {}
+
+void IncrementalConverter::reset()
+{
+    units.clear();
+    names.clear();
+    source.clear();
+    sourceLines = 0;
+    output.clear();
+    converted = false;
+}
+
+// ==================== ACTUALIZACIÓN ====================
+
+const std::string& IncrementalConverter::update(std::string_view text)
+{
+    if (names.size() > maxInternedWords) reset();
+    if (converted && text == source) {
+        lastReparsed = 0;
+        lastReused = int(units.size());
+        return output;
+    }
+
+    std::size_t fromUnit = 0;
+    int safeLine = 0;
+    int lineDelta = 0;
+    std::ptrdiff_t byteDelta = 0;
+
+    if (converted) {
+        // Zona modificada: lo que queda entre el prefijo y el sufijo comunes
+        const char* oldBegin = source.data();
+        const char* newBegin = text.data();
+        const std::size_t common = std::min(source.size(), text.size());
+
+        const std::size_t prefix = std::size_t(std::mismatch(oldBegin, oldBegin + common, newBegin).first - oldBegin);
+
+        const auto rOld = std::make_reverse_iterator(oldBegin + source.size());
+        const auto rNew = std::make_reverse_iterator(newBegin + text.size());
+        const std::size_t suffix = std::size_t(std::mismatch(rOld, rOld + std::ptrdiff_t(common - prefix), rNew).first - rOld);
+
+        const std::size_t oldSuffixStart = source.size() - suffix;
+        const std::size_t newSuffixStart = text.size() - suffix;
+
+        const int firstChanged = countLines(std::string_view(source).substr(0, prefix));
+
+        // Primera línea vieja intacta (contenido y comienzo de línea en ambos textos)
+        const bool boundary = isLineStart(source, oldSuffixStart) && isLineStart(text, newSuffixStart);
+        safeLine = countLines(std::string_view(source).substr(0, oldSuffixStart)) + (boundary ? 0 : 1);
+
+        lineDelta = countLines(text) - sourceLines;
+        byteDelta = std::ptrdiff_t(text.size()) - std::ptrdiff_t(source.size());
+
+        // Unidad que contiene la primera línea modificada; las anteriores no cambian
+        fromUnit = unitContaining(firstChanged);
+    }
+
+    reparse(text, fromUnit, safeLine, lineDelta, byteDelta);
+
+    source.assign(text);
+    sourceLines = countLines(source);
+    converted = true;
+
+    generate();
+    return output;
+}
+
+const std::string& IncrementalConverter::replaceLines(int firstLine, int count, std::string_view lines)
+{
+    // Tramo viejo: desde el comienzo de 'firstLine' hasta el fin de la última línea, sin su '\n'
+    const std::size_t begin = lineStart(firstLine);
+    std::size_t end = begin;
+    for (int i = 1; i < count; ++i) end = source.find('\n', end) + 1;
+    end = std::min(source.find('\n', end), source.size());
+
+    if (source.compare(begin, end - begin, lines) == 0) {
+        lastReparsed = 0;
+        lastReused = int(units.size());
+        return output;
+    }
+
+    const int lineDelta = countLines(lines) - (count - 1);
+    const std::ptrdiff_t byteDelta = std::ptrdiff_t(lines.size()) - std::ptrdiff_t(end - begin);
+    source.replace(begin, end - begin, lines);
+    sourceLines += lineDelta;
+
+    if (names.size() > maxInternedWords) {
+        std::string text;
+        text.swap(source);
+        reset();
+        return update(text);
+    }
+
+    // Lo anterior a 'begin' no cambió (las unidades previas conservan su
+    // posición) y las líneas viejas desde firstLine + count están intactas
+    reparse(source, unitContaining(firstLine), firstLine + count, lineDelta, byteDelta);
+    generate();
+    return output;
+}
+
+std::size_t IncrementalConverter::unitContaining(int line) const
+{
+    auto it = std::upper_bound(units.begin(), units.end(), line,
+        [](int l, const Unit& unit) { return l < unit.firstLine; });
+    return it == units.begin() ? 0 : std::size_t(it - units.begin()) - 1;
+}
+
+// Solo se recorren las líneas desde el comienzo de la unidad que contiene 'line'
+std::size_t IncrementalConverter::lineStart(int line) const
+{
+    int walkLine = 0;
+    std::size_t pos = 0;
+    if (!units.empty()) {
+        const Unit& unit = units[unitContaining(line)];
+        if (unit.firstLine <= line) {
+            walkLine = unit.firstLine;
+            pos = unit.firstPos;
+        }
+    }
+    for (; walkLine < line; ++walkLine) pos = source.find('\n', pos) + 1;
+    return pos;
+}
+
+// ==================== PARSEO POR UNIDADES ====================
+
+void IncrementalConverter::reparse(std::string_view text, std::size_t fromUnit, int safeLine, int lineDelta, std::ptrdiff_t byteDelta)
+{
+    // Desde la primera unidad se reparsea desde el inicio (puede haber líneas nuevas antes)
+    const bool fromStart = fromUnit == 0 || fromUnit >= units.size();
+    const int baseLine = fromStart ? 0 : units[fromUnit].firstLine;
+    const std::size_t basePos = fromStart ? 0 : units[fromUnit].firstPos;
+    if (fromStart) fromUnit = 0;
+
+    // Posición de cada línea nueva, avanzando solo por la zona reparseada
+    int walkLine = baseLine;
+    std::size_t walkPos = basePos;
+    auto positionOf = [&](int line) {
+        while (walkLine < line) {
+            walkPos = text.find('\n', walkPos) + 1;
+            ++walkLine;
+        }
+        return walkPos;
+    };
+
+    auto arena = std::make_shared<Arena>(passArenaSize);
+    std::vector<Unit> fresh;
+    std::size_t resyncAt = units.size();
+
+    StringLineReader reader(text.substr(basePos));
+    processor.processUnits(reader, *arena, names, [&](const ParsedUnit& parsed) {
+        Unit unit;
+        unit.firstLine = baseLine + parsed.firstLine;
+        unit.firstPos = positionOf(unit.firstLine);
+        unit.arena = arena;
+        unit.instructions = parsed.instructions;
+        unit.closesProgram = parsed.closesProgram;
+        for (const auto& ins : parsed.instructions) {
+            if (ins.type == InstructionType::FunctionDefinition) {
+                unit.hasDefinitions = true;
+            }
+            else if (ins.type != InstructionType::ProgramStart && ins.type != InstructionType::ProgramEnd) {
+                unit.hasStatements = true;
+            }
+        }
+        fresh.push_back(std::move(unit));
+
+        if (parsed.closesProgram) return false;
+
+        // ¿La siguiente unidad empieza donde empezaba una unidad vieja, ya fuera de la zona editada?
+        const int nextOld = baseLine + parsed.nextLine - lineDelta;
+        if (nextOld < safeLine) return true;
+
+        auto it = std::lower_bound(units.begin() + std::ptrdiff_t(std::min(fromUnit + 1, units.size())), units.end(), nextOld,
+            [](const Unit& u, int line) { return u.firstLine < line; });
+        if (it != units.end() && it->firstLine == nextOld) {
+            resyncAt = std::size_t(it - units.begin());
+            return false;
+        }
+        return true;
+    });
+
+    lastReparsed = int(fresh.size());
+    lastReused = int(fromUnit) + int(units.size() - resyncAt);
+
+    // Unidades viejas posteriores: se desplazan, no se reparsean
+    for (std::size_t i = resyncAt; i < units.size(); ++i) {
+        units[i].firstLine += lineDelta;
+        units[i].firstPos = std::size_t(std::ptrdiff_t(units[i].firstPos) + byteDelta);
+        fresh.push_back(std::move(units[i]));
+    }
+    units.resize(fromUnit);
+    for (Unit& unit : fresh) units.push_back(std::move(unit));
+}
+
+// ==================== GENERACIÓN ====================
+
+void IncrementalConverter::generate()
+{
+    const std::size_t expected = output.size();
+    output.clear();
+    StringSink out(output, expected);
+
+    generator.beginProgram(names);
+
+    // 1) Análisis: cada unidad lo calcula una vez y luego se reproduce
+    for (Unit& unit : units) {
+        if (unit.analyzed) {
+            generator.replay(unit.analysis);
+        }
+        else {
+            generator.analyze(unit.instructions, &unit.analysis);
+            unit.analyzed = true;
+        }
+    }
+    generator.resolveFunctions();
+
+    // 2) Includes
+    generator.writePrologue(out);
+
+    // 3) Definiciones de funciones
+    for (Unit& unit : units) {
+        if (unit.hasDefinitions) emitFragment(unit.definitions, unit.instructions, true, out);
+    }
+
+    // 4) main()
+    generator.writeMainOpen(out);
+
+    // 5) Cuerpo
+    for (Unit& unit : units) {
+        if (unit.hasStatements) emitFragment(unit.statements, unit.instructions, false, out);
+    }
+
+    // 6) Cerrar main
+    generator.writeEpilogue(out);
+    generator.endProgram();
+}
+
+// Copia el fragmento cacheado si su estado de entrada no cambió; si no, lo regenera
+void IncrementalConverter::emitFragment(Fragment& fragment, InstructionList instructions, bool definitions, CodeSink& out)
+{
+    // Las definiciones leen la tabla de símbolos; las sentencias de main no
+    const CodeGenerator::FragmentState entry = generator.fragmentState(definitions);
+
+    if (fragment.valid && fragment.entry == entry) {
+        generator.replay(fragment.effects);
+        out << fragment.code;
+        return;
+    }
+
+    fragment.code.clear();
+    StringSink sink(fragment.code);
+    if (definitions) {
+        generator.writeFunctionDefinitions(instructions, sink, &fragment.effects);
+    }
+    else {
+        generator.writeStatements(instructions, sink, &fragment.effects);
+    }
+    fragment.entry = entry;
+    fragment.valid = true;
+
+    out << fragment.code;
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "natural_language_processor.h"
+#include "code_generator.h"
+
+// Conversión en vivo: mantiene el programa dividido en unidades de nivel
+// superior (una instrucción simple o un bloque 'si'/'fin si', 'definir
+// funcion'/'fin funcion', etc.). En cada actualización solo se reparsean las
+// unidades que tocan las líneas modificadas, y solo se regenera el código de
+// las unidades cuyo texto o estado de entrada cambió; el resto se copia de la
+// caché. La salida es idéntica a la de Converter::convert.
+class IncrementalConverter
+{
+public:
+    IncrementalConverter();
+    ~IncrementalConverter();
+
+    // Convierte 'text' (UTF-8) reutilizando lo que no cambió desde la llamada anterior
+    const std::string& update(std::string_view text);
+
+    // Igual que update() con el texto anterior editado, sin recibir ni
+    // comparar el texto completo: las líneas [firstLine, firstLine + count)
+    // pasan a ser 'lines' (separadas por '\n', sin '\n' final). Requiere una
+    // actualización anterior y que esas líneas existan (ver lineCount).
+    const std::string& replaceLines(int firstLine, int count, std::string_view lines);
+
+    // Líneas del texto de la última actualización (0 si no hubo ninguna)
+    int lineCount() const { return converted ? sourceLines + 1 : 0; }
+
+    // Olvida la caché; la próxima actualización convierte desde cero
+    void reset();
+
+    // Unidades reparseadas y reutilizadas en la última actualización
+    int reparsedUnits() const { return lastReparsed; }
+    int reusedUnits() const { return lastReused; }
+
+private:
+    // Código generado para una unidad y el estado con el que se generó
+    struct Fragment {
+        bool valid = false;
+        CodeGenerator::FragmentState entry;
+        CodeGenerator::FragmentEffects effects;
+        std::string code;
+    };
+
+    struct Unit {
+        int firstLine = 0;                  // primera línea no vacía
+        std::size_t firstPos = 0;           // posición (en bytes) de esa línea en el texto
+        std::shared_ptr<Arena> arena;       // arena de la pasada que la parseó
+        InstructionList instructions;
+        bool closesProgram = false;
+        bool hasDefinitions = false;
+        bool hasStatements = false;
+
+        bool analyzed = false;
+        CodeGenerator::FragmentEffects analysis;       // análisis semántico
+        Fragment definitions;                          // funciones, antes de main
+        Fragment statements;                           // cuerpo de main
+    };
+
+    // Reparsea desde la unidad 'fromUnit' hasta volver a coincidir con una
+    // unidad vieja que empiece en la línea 'safeLine' o después
+    void reparse(std::string_view text, std::size_t fromUnit, int safeLine, int lineDelta, std::ptrdiff_t byteDelta);
+    // Unidad que contiene 'line' (o la primera) y posición de 'line' en 'source'
+    std::size_t unitContaining(int line) const;
+    std::size_t lineStart(int line) const;
+    void generate();
+    void emitFragment(Fragment& fragment, InstructionList instructions, bool definitions, CodeSink& out);
+
+    NaturalLanguageProcessor processor;
+    CodeGenerator generator;
+    Interner names;             // compartido por todas las pasadas
+
+    std::string source;         // texto de la última actualización
+    int sourceLines = 0;        // saltos de línea en 'source'
+    std::string output;
+    std::vector<Unit> units;
+    bool converted = false;
+
+    int lastReparsed = 0;
+    int lastReused = 0;
+};
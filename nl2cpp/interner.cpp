@@ -0,0 +1,75 @@
+﻿#include "stdafx.h"
+#include "interner.h"
+
+#include <algorithm>
+
+// ==================== HASH ====================
+// FNV-1a sobre los bytes UTF-8: estable entre ejecuciones y sin depender de
+// una semilla aleatoria.
+std::uint32_t Interner::hashOf(std::string_view text)
+{
+    std::uint32_t h = 2166136261u;
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Posición de 'text' en la tabla, o del hueco donde debería insertarse
+std::size_t Interner::slotOf(std::string_view text, std::uint32_t hash) const
+{
+    const std::size_t mask = table.size() - 1;
+    std::size_t i = hash & mask;
+    while (table[i] != NoSymbol) {
+        const SymbolId id = table[i];
+        if (hashes[id - 1] == hash && texts[id - 1] == text) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// ==================== INTERNADO ====================
+
+SymbolId Interner::intern(std::string_view text)
+{
+    // Carga máxima de 1/2 para que las secuencias de sondeo sean cortas
+    if ((texts.size() + 1) * 2 > table.size()) {
+        rehash(table.empty() ? 256 : table.size() * 2);
+    }
+
+    const std::uint32_t hash = hashOf(text);
+    const std::size_t slot = slotOf(text, hash);
+    if (table[slot] != NoSymbol) return table[slot];
+
+    const ArenaSpan<char> copy = storage.copyArray(text.data(), text.size());
+    texts.push_back(std::string_view(copy.items, copy.count));
+    hashes.push_back(hash);
+    table[slot] = SymbolId(texts.size());
+    return table[slot];
+}
+
+SymbolId Interner::find(std::string_view text) const
+{
+    if (table.empty()) return NoSymbol;
+    return table[slotOf(text, hashOf(text))];
+}
+
+void Interner::clear()
+{
+    texts.clear();
+    hashes.clear();
+    storage.reset();
+    std::fill(table.begin(), table.end(), NoSymbol);
+}
+
+void Interner::rehash(std::size_t capacity)
+{
+    table.assign(capacity, NoSymbol);
+    const std::size_t mask = capacity - 1;
+    for (SymbolId id = 1; id <= texts.size(); ++id) {
+        std::size_t i = hashes[id - 1] & mask;
+        while (table[i] != NoSymbol) i = (i + 1) & mask;
+        table[i] = id;
+    }
+}
@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+// Identificador entero de una palabra internada (0 = sin símbolo)
+using SymbolId = std::uint32_t;
+constexpr SymbolId NoSymbol = 0;
+
+// Tabla de internado: asigna a cada palabra distinta un SymbolId denso
+// (1, 2, 3...), de modo que comparar o buscar identificadores sea comparar
+// enteros. Cada palabra nueva se copia una vez a su propio arena, así el
+// interner puede sobrevivir al texto de origen y compartirse entre programas.
+class Interner
+{
+public:
+    Interner() : storage(4 * 1024) {}
+
+    SymbolId intern(std::string_view text);
+
+    // SymbolId de 'text' si ya fue internado, o NoSymbol
+    SymbolId find(std::string_view text) const;
+
+    std::string_view text(SymbolId id) const { return texts[id - 1]; }
+    std::size_t size() const { return texts.size(); }
+
+    // Vacía la tabla conservando su capacidad
+    void clear();
+
+private:
+    static std::uint32_t hashOf(std::string_view text);
+    std::size_t slotOf(std::string_view text, std::uint32_t hash) const;
+    void rehash(std::size_t capacity);
+
+    Arena storage;                      // copias de las palabras internadas
+    std::vector<std::string_view> texts;     // texts[id - 1]
+    std::vector<std::uint32_t> hashes;  // hashes[id - 1]
+    std::vector<SymbolId> table;        // direccionamiento abierto, 0 = vacío
+};
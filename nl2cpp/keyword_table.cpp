@@ -0,0 +1,140 @@
+﻿#include "stdafx.h"
+#include "keyword_table.h"
+#include "natural_language_processor.h"
+
+#include <string_view>
+
+namespace {
+
+struct Entry {
+    std::string_view text;
+    Phrase phrase;
+    InstructionType type;
+    std::string_view keyword;
+};
+
+// ==================== FRASES CLAVE ====================
+// Texto ya normalizado (minúsculas, sin tildes, un espacio entre palabras)
+constexpr Entry entries[] = {
+    // Inicio / fin de programa
+    { "comenzar programa", Phrase::ComenzarPrograma, InstructionType::ProgramStart,       "comenzar programa" },
+    { "terminar programa", Phrase::TerminarPrograma, InstructionType::ProgramEnd,         "terminar programa" },
+
+    // Funciones
+    { "definir funcion",   Phrase::DefinirFuncion,   InstructionType::FunctionDefinition, "definir funcion" },
+    { "llamar funcion",    Phrase::LlamarFuncion,    InstructionType::FunctionCall,       "llamar funcion" },
+    { "fin funcion",       Phrase::FinFuncion,       InstructionType::Unknown,            "fin funcion" },
+
+    // Control
+    { "fin si",            Phrase::FinSi,            InstructionType::Unknown,            "fin" },
+    { "fin mientras",      Phrase::FinMientras,      InstructionType::Unknown,            "fin" },
+    { "fin para",          Phrase::FinPara,          InstructionType::Unknown,            "fin" },
+    { "si",                Phrase::Si,               InstructionType::ControlStructure,   "si" },
+    { "sino",              Phrase::Sino,             InstructionType::ControlStructure,   "sino" },
+    { "mientras",          Phrase::Mientras,         InstructionType::ControlStructure,   "mientras" },
+    { "para",              Phrase::Para,             InstructionType::ControlStructure,   "para" },
+    { "repetir",           Phrase::Repetir,          InstructionType::ControlStructure,   "repetir" },
+    { "repetir hasta",     Phrase::RepetirHasta,     InstructionType::ControlStructure,   "repetir" },
+    { "hasta",             Phrase::Hasta,            InstructionType::ControlStructure,   "hasta" },
+    { "hasta que",         Phrase::HastaQue,         InstructionType::ControlStructure,   "hasta que" },
+
+    // Asignación y variables
+    { "asignar",           Phrase::Asignar,          InstructionType::Assignment,         "asignar" },
+    { "crear variable",    Phrase::CrearVariable,    InstructionType::VariableDeclaration, "crear" },
+
+    // Entrada / salida
+    { "mostrar",           Phrase::Mostrar,          InstructionType::Output,             "mostrar" },
+    { "imprimir",          Phrase::Imprimir,         InstructionType::Output,             "imprimir" },
+    { "mensaje",           Phrase::Mensaje,          InstructionType::Output,             "mensaje" },
+    { "leer",              Phrase::Leer,             InstructionType::Input,              "leer" },
+    { "ingresar valor",    Phrase::IngresarValor,    InstructionType::Input,              "ingresar" },
+
+    // Aritmética
+    { "sumar",             Phrase::Sumar,            InstructionType::Arithmetic,         "sumar" },
+    { "restar",            Phrase::Restar,           InstructionType::Arithmetic,         "restar" },
+    { "multiplicar",       Phrase::Multiplicar,      InstructionType::Arithmetic,         "multiplicar" },
+    { "dividir",           Phrase::Dividir,          InstructionType::Arithmetic,         "dividir" },
+    { "total",             Phrase::Total,            InstructionType::Arithmetic,         "total" },
+    { "resultado",         Phrase::Resultado,        InstructionType::Arithmetic,         "resultado" }
+};
+
+constexpr int entryCount = int(sizeof(entries) / sizeof(entries[0]));
+
+// ==================== TRIE CONSTEXPR ====================
+// Alfabeto: 'a'..'z' y el espacio. Cada nodo guarda sus 27 hijos (0 = sin hijo)
+// y el índice + 1 de la entrada que termina en él.
+
+constexpr int alphabetSize = 27;
+
+constexpr int symbolOf(char c)
+{
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c == ' ') return 26;
+    return -1;
+}
+
+constexpr int maxNodes()
+{
+    int total = 1;
+    for (const Entry& e : entries) total += int(e.text.size());
+    return total;
+}
+
+struct Trie {
+    std::int16_t next[maxNodes()][alphabetSize];
+    std::int8_t terminal[maxNodes()];
+    int nodeCount;
+};
+
+constexpr Trie buildTrie()
+{
+    Trie trie{};
+    trie.nodeCount = 1;
+    for (int e = 0; e < entryCount; ++e) {
+        int node = 0;
+        for (char c : entries[e].text) {
+            const int sym = symbolOf(c);
+            if (trie.next[node][sym] == 0) {
+                trie.next[node][sym] = std::int16_t(trie.nodeCount++);
+            }
+            node = trie.next[node][sym];
+        }
+        trie.terminal[node] = std::int8_t(e + 1);
+    }
+    return trie;
+}
+
+constexpr Trie trie = buildTrie();
+
+static_assert(entryCount < 127, "terminal usa int8_t");
+
+} // namespace
+
+// ==================== CLASIFICACIÓN ====================
+
+PhraseMatch KeywordTable::match(std::string_view line)
+{
+    PhraseMatch result;
+    int node = 0;
+
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        const int sym = symbolOf(line[i]);
+        if (sym < 0) break;
+
+        node = trie.next[node][sym];
+        if (node == 0) break;
+
+        // Solo cuentan frases que terminan en límite de palabra ("si" no coincide
+        // con "sistema"); '(', ':' y ',' también lo son ("si(x > 3)", "mostrar: x")
+        const bool boundary = (i + 1 == line.size()) || line[i + 1] == ' ' ||
+            line[i + 1] == '(' || line[i + 1] == ':' || line[i + 1] == ',';
+        if (boundary && trie.terminal[node] != 0) {
+            const Entry& e = entries[trie.terminal[node] - 1];
+            result.phrase = e.phrase;
+            result.type = e.type;
+            result.keyword = e.keyword;
+            result.length = i + 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+enum class InstructionType;
+
+// Frases clave reconocidas al inicio de una línea
+enum class Phrase : std::uint8_t {
+    None,
+    ComenzarPrograma,
+    TerminarPrograma,
+    DefinirFuncion,
+    LlamarFuncion,
+    FinFuncion,
+    FinSi,
+    FinMientras,
+    FinPara,
+    Si,
+    Sino,
+    Mientras,
+    Para,
+    Repetir,
+    RepetirHasta,
+    Hasta,
+    HastaQue,
+    Asignar,
+    CrearVariable,
+    Mostrar,
+    Imprimir,
+    Mensaje,
+    Leer,
+    IngresarValor,
+    Sumar,
+    Restar,
+    Multiplicar,
+    Dividir,
+    Total,
+    Resultado
+};
+
+// Resultado de clasificar el inicio de una línea
+struct PhraseMatch {
+    Phrase phrase = Phrase::None;
+    InstructionType type{};     // solo válido si phrase != None
+    std::string_view keyword;   // keyword de la instrucción (literal estático)
+    std::size_t length = 0;     // bytes consumidos por la frase
+
+    explicit operator bool() const { return phrase != Phrase::None; }
+};
+
+// Tabla de frases clave compilada como un trie constexpr: clasifica la frase
+// inicial de una línea normalizada en O(longitud de la frase), sin
+// diccionarios construidos en tiempo de ejecución.
+class KeywordTable
+{
+public:
+    // Frase más larga que coincide con el inicio de 'line' y termina en límite de palabra
+    static PhraseMatch match(std::string_view line);
+};
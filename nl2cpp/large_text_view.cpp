@@ -0,0 +1,223 @@
+﻿#include "stdafx.h"
+#include "large_text_view.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+namespace {
+// Margen izquierdo del texto, en píxeles
+constexpr int textMargin = 6;
+}
+
+// ==================== CONSTRUCTOR ====================
+LargeTextView::LargeTextView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+{
+    // Monoespaciada: el ancho de cualquier tramo se calcula sin maquetarlo
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    lineStarts.push_back(0);
+}
+
+// ==================== CONTENIDO ====================
+
+// Un solo recorrido del texto para indexar las líneas; nada se maqueta aquí
+void LargeTextView::setText(QString text)
+{
+    buffer = std::move(text);
+    lineStarts.assign(1, 0);
+    indexLines(0);
+
+    anchorLine = selectionFirst = selectionLast = -1;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+}
+
+// Las líneas que empiezan dentro del prefijo común no cambian: se conservan
+// sus posiciones y solo se recorre el texto desde el primer carácter distinto
+void LargeTextView::updateText(QString text)
+{
+    const qsizetype common = qMin(buffer.size(), text.size());
+    const QChar* oldData = buffer.constData();
+    const qsizetype prefix = qsizetype(std::mismatch(oldData, oldData + common, text.constData()).first - oldData);
+    if (prefix == buffer.size() && prefix == text.size()) return;
+
+    const int vertical = verticalScrollBar()->value();
+    const int horizontal = horizontalScrollBar()->value();
+
+    buffer = std::move(text);
+    lineStarts.erase(std::upper_bound(lineStarts.begin(), lineStarts.end(), prefix), lineStarts.end());
+    indexLines(prefix);
+
+    if (selectionLast >= lineCount()) {
+        selectionLast = lineCount() - 1;
+        if (selectionFirst > selectionLast) anchorLine = selectionFirst = selectionLast = -1;
+        else anchorLine = qMin(anchorLine, selectionLast);
+    }
+
+    updateScrollBars();
+    verticalScrollBar()->setValue(vertical);
+    horizontalScrollBar()->setValue(horizontal);
+    viewport()->update();
+}
+
+// Agrega los comienzos de línea posteriores a 'from' (los anteriores ya están
+// en 'lineStarts') y recalcula la línea más larga
+void LargeTextView::indexLines(qsizetype from)
+{
+    const QChar* data = buffer.constData();
+    const qsizetype size = buffer.size();
+    for (qsizetype i = from; i < size; ++i) {
+        if (data[i] == u'\n') lineStarts.push_back(i + 1);
+    }
+
+    longestLine = size - lineStarts.back();
+    for (std::size_t i = 1; i < lineStarts.size(); ++i) {
+        longestLine = qMax(longestLine, lineStarts[i] - 1 - lineStarts[i - 1]);
+    }
+}
+
+QStringView LargeTextView::line(qsizetype index) const
+{
+    const qsizetype begin = lineStarts[index];
+    qsizetype end = index + 1 < lineCount() ? lineStarts[index + 1] - 1 : buffer.size();
+    if (end > begin && buffer[end - 1] == u'\r') --end;
+    return QStringView(buffer).mid(begin, end - begin);
+}
+
+// ==================== DESPLAZAMIENTO ====================
+
+// La barra vertical cuenta líneas y la horizontal caracteres
+void LargeTextView::updateScrollBars()
+{
+    const QFontMetrics metrics(font());
+    const int visibleLines = qMax(1, viewport()->height() / metrics.lineSpacing());
+    const int visibleChars = qMax(1, (viewport()->width() - textMargin) / qMax(1, metrics.horizontalAdvance(u'M')));
+
+    QScrollBar* vertical = verticalScrollBar();
+    vertical->setRange(0, int(qMax<qsizetype>(0, lineCount() - visibleLines)));
+    vertical->setPageStep(visibleLines);
+    vertical->setSingleStep(1);
+
+    QScrollBar* horizontal = horizontalScrollBar();
+    horizontal->setRange(0, int(qMin<qsizetype>(INT_MAX, qMax<qsizetype>(0, longestLine - visibleChars + 1))));
+    horizontal->setPageStep(visibleChars);
+    horizontal->setSingleStep(1);
+}
+
+void LargeTextView::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+// ==================== PINTADO ====================
+
+// Solo las líneas visibles, y de cada una solo el tramo que entra en pantalla
+void LargeTextView::paintEvent(QPaintEvent*)
+{
+    QPainter painter(viewport());
+    const QFontMetrics metrics(font());
+    const int lineHeight = metrics.lineSpacing();
+    const int charWidth = qMax(1, metrics.horizontalAdvance(u'M'));
+    const qsizetype firstChar = horizontalScrollBar()->value();
+    const qsizetype visibleChars = viewport()->width() / charWidth + 2;
+
+    const qsizetype first = verticalScrollBar()->value();
+    const qsizetype last = qMin(lineCount(), first + viewport()->height() / lineHeight + 2);
+
+    const QPalette& colors = palette();
+    int y = 0;
+    for (qsizetype i = first; i < last; ++i, y += lineHeight) {
+        const QRect row(0, y, viewport()->width(), lineHeight);
+        const bool selected = selectionFirst != -1 && i >= selectionFirst && i <= selectionLast;
+        if (selected) painter.fillRect(row, colors.highlight());
+        painter.setPen(selected ? colors.highlightedText().color() : colors.text().color());
+
+        const QStringView text = line(i);
+        if (firstChar >= text.size()) continue;
+        painter.drawText(row.adjusted(textMargin, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine,
+                         text.mid(firstChar, visibleChars).toString());
+    }
+}
+
+// ==================== SELECCIÓN Y TECLADO ====================
+
+qsizetype LargeTextView::lineAt(int y) const
+{
+    const int lineHeight = QFontMetrics(font()).lineSpacing();
+    const qsizetype index = verticalScrollBar()->value() + qMax(0, y) / lineHeight;
+    return qMin(index, lineCount() - 1);
+}
+
+void LargeTextView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() != Qt::LeftButton) return;
+    const qsizetype index = lineAt(int(event->position().y()));
+    if (!(event->modifiers() & Qt::ShiftModifier) || anchorLine == -1) anchorLine = index;
+    selectionFirst = qMin(anchorLine, index);
+    selectionLast = qMax(anchorLine, index);
+    viewport()->update();
+}
+
+void LargeTextView::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!(event->buttons() & Qt::LeftButton) || anchorLine == -1) return;
+
+    // Arrastrar fuera de la vista la desplaza
+    const int y = int(event->position().y());
+    QScrollBar* vertical = verticalScrollBar();
+    if (y < 0) vertical->setValue(vertical->value() - 1);
+    else if (y > viewport()->height()) vertical->setValue(vertical->value() + 1);
+
+    const qsizetype index = lineAt(qMin(y, viewport()->height()));
+    selectionFirst = qMin(anchorLine, index);
+    selectionLast = qMax(anchorLine, index);
+    viewport()->update();
+}
+
+void LargeTextView::keyPressEvent(QKeyEvent* event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        copySelection();
+        return;
+    }
+    if (event->matches(QKeySequence::SelectAll)) {
+        anchorLine = selectionFirst = 0;
+        selectionLast = lineCount() - 1;
+        viewport()->update();
+        return;
+    }
+
+    QScrollBar* vertical = verticalScrollBar();
+    switch (event->key()) {
+    case Qt::Key_Home:     vertical->setValue(0); break;
+    case Qt::Key_End:      vertical->setValue(vertical->maximum()); break;
+    case Qt::Key_PageUp:   vertical->triggerAction(QAbstractSlider::SliderPageStepSub); break;
+    case Qt::Key_PageDown: vertical->triggerAction(QAbstractSlider::SliderPageStepAdd); break;
+    case Qt::Key_Up:       vertical->triggerAction(QAbstractSlider::SliderSingleStepSub); break;
+    case Qt::Key_Down:     vertical->triggerAction(QAbstractSlider::SliderSingleStepAdd); break;
+    default:               QAbstractScrollArea::keyPressEvent(event); break;
+    }
+}
+
+void LargeTextView::copySelection() const
+{
+    if (selectionFirst == -1) return;
+
+    const qsizetype begin = lineStarts[selectionFirst];
+    const qsizetype end = selectionLast + 1 < lineCount() ? lineStarts[selectionLast + 1] : buffer.size();
+    QApplication::clipboard()->setText(buffer.mid(begin, end - begin));
+}
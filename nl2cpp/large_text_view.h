@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <QAbstractScrollArea>
+#include <QString>
+#include <QStringView>
+#include <vector>
+
+// Vista de solo lectura para documentos enormes. Guarda el texto en un único
+// QString con un índice de comienzos de línea y, al pintar, solo maqueta las
+// líneas visibles: abrir o desplazarse por 100k+ líneas cuesta lo mismo que
+// por cien. Permite seleccionar líneas completas y copiarlas (Ctrl+C, Ctrl+A).
+class LargeTextView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit LargeTextView(QWidget* parent = nullptr);
+
+    void setText(QString text);
+
+    // Como setText, pero conserva el desplazamiento y la selección, y solo
+    // vuelve a indexar desde la primera línea que cambió
+    void updateText(QString text);
+    const QString& text() const { return buffer; }
+    void clear() { setText(QString()); }
+
+    qsizetype lineCount() const { return qsizetype(lineStarts.size()); }
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+
+private:
+    void indexLines(qsizetype from);
+    QStringView line(qsizetype index) const;
+    qsizetype lineAt(int y) const;
+    void updateScrollBars();
+    void copySelection() const;
+
+    QString buffer;
+    std::vector<qsizetype> lineStarts;  // posición de cada línea en 'buffer'
+    qsizetype longestLine = 0;          // en caracteres, para la barra horizontal
+
+    // Selección de líneas [selectionFirst, selectionLast]; -1 = ninguna
+    qsizetype anchorLine = -1;
+    qsizetype selectionFirst = -1;
+    qsizetype selectionLast = -1;
+};
@@ -0,0 +1,278 @@
+﻿#include "stdafx.h"
+#include "lexer.h"
+#include "utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define NL2CPP_LEXER_SSE2 1
+#endif
+
+#if defined(NL2CPP_LEXER_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Latin-1 U+00C0..U+00FF -> minúscula, y vocales sin tilde/diéresis (la ñ se conserva)
+const char16_t latin1Fold[64] = {
+    'a', 'a', 'a', 'a', 'a', 'a', 0xE6, 0xE7, 'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i',
+    0xF0, 0xF1, 'o', 'o', 'o', 'o', 'o', 0xD7, 0xF8, 'u', 'u', 'u', 'u', 0xFD, 0xFE, 0xDF,
+    'a', 'a', 'a', 'a', 'a', 'a', 0xE6, 0xE7, 'e', 'e', 'e', 'e', 'i', 'i', 'i', 'i',
+    0xF0, 0xF1, 'o', 'o', 'o', 'o', 'o', 0xF7, 0xF8, 'u', 'u', 'u', 'u', 0xFD, 0xFE, 0xFF
+};
+
+// Marcas combinantes de tilde, grave, circunflejo y diéresis (formas descompuestas)
+inline bool isDroppedMark(char32_t c)
+{
+    return c == 0x0300 || c == 0x0301 || c == 0x0302 || c == 0x0308;
+}
+
+// Nunca ocupa más bytes que 'c': la salida del lexer cabe en el tamaño de la entrada
+inline char32_t foldChar(char32_t c)
+{
+    if (c >= 0xC0 && c <= 0xFF) return latin1Fold[c - 0xC0];
+    return Utf8::toLower(c);
+}
+
+// Clases de carácter ASCII para clasificar tokens
+enum CharClass : std::uint8_t {
+    CharOther  = 0,
+    CharLetter = 1,     // a-z, A-Z, '_'
+    CharDigit  = 2,
+    CharSign   = 4      // '+', '-'
+};
+
+struct CharClassTable {
+    std::uint8_t classes[128];
+
+    constexpr CharClassTable() : classes{} {
+        for (int c = 'a'; c <= 'z'; ++c) classes[c] = CharLetter;
+        for (int c = 'A'; c <= 'Z'; ++c) classes[c] = CharLetter;
+        for (int c = '0'; c <= '9'; ++c) classes[c] = CharDigit;
+        classes['_'] = CharLetter;
+        classes['+'] = CharSign;
+        classes['-'] = CharSign;
+    }
+};
+
+constexpr CharClassTable charClasses;
+
+inline std::uint8_t charClass(char c)
+{
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u < 0x80 ? charClasses.classes[u] : std::uint8_t(CharOther);
+}
+
+// Palabras que no pueden nombrar una variable ni un arreglo
+constexpr std::string_view reservedWords[] = {
+    "crear", "lista", "arreglo", "de", "con", "elementos",
+    "entero", "enteros", "decimal", "decimales", "texto", "string",
+    "palabra", "cadena", "caracter", "caracteres", "booleano", "booleanos", "bool"
+};
+
+inline bool isReserved(std::string_view word)
+{
+    for (std::string_view reserved : reservedWords) {
+        if (word == reserved) return true;
+    }
+    return false;
+}
+
+// Identificador, palabra reservada, entero ([+-]dígitos) o decimal
+// ([+-]dígitos.dígitos[e[+-]dígitos], con al menos un dígito antes del exponente)
+TokenKind classify(const char* p, std::size_t length)
+{
+    if (charClass(p[0]) & CharLetter) {
+        for (std::size_t i = 1; i < length; ++i) {
+            if (!(charClass(p[i]) & (CharLetter | CharDigit))) return TokenKind::Other;
+        }
+        return isReserved(std::string_view(p, length)) ? TokenKind::Keyword : TokenKind::Identifier;
+    }
+
+    std::size_t i = (charClass(p[0]) & CharSign) ? 1 : 0;
+    std::size_t digits = 0;
+    bool decimal = false;
+
+    for (; i < length && (charClass(p[i]) & CharDigit); ++i) ++digits;
+    if (i < length && p[i] == '.') {
+        decimal = true;
+        for (++i; i < length && (charClass(p[i]) & CharDigit); ++i) ++digits;
+    }
+    if (digits == 0) return TokenKind::Other;
+
+    if (i < length && (p[i] == 'e' || p[i] == 'E')) {
+        decimal = true;
+        if (++i < length && (charClass(p[i]) & CharSign)) ++i;
+        std::size_t exponent = 0;
+        for (; i < length && (charClass(p[i]) & CharDigit); ++i) ++exponent;
+        if (exponent == 0) return TokenKind::Other;
+    }
+
+    if (i != length) return TokenKind::Other;
+    return decimal ? TokenKind::Decimal : TokenKind::Integer;
+}
+
+#ifdef NL2CPP_LEXER_SSE2
+inline int countTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return int(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Procesa hasta 16 bytes ASCII imprimibles (sin comillas) de una vez:
+// los copia a 'dst' en minúscula y devuelve cuántos eran válidos desde el inicio.
+// Siempre escribe 16 posiciones en 'dst'; el llamador reserva la holgura.
+// Los bytes >= 0x80 son negativos en la comparación con signo: cortan el tramo.
+inline int lowerAsciiRun(const char* src, char* dst)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    const __m128i printable = _mm_and_si128(
+        _mm_cmpgt_epi8(v, _mm_set1_epi8(0x20)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+    const __m128i ok = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), printable);
+
+    const unsigned mask = unsigned(_mm_movemask_epi8(ok));
+    if (mask == 0) return 0;
+
+    const __m128i upper = _mm_and_si128(
+        _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+        _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    const __m128i lowered = _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lowered);
+
+    return (mask == 0xFFFF) ? 16 : countTrailingZeros(~mask & 0xFFFF);
+}
+#endif
+
+} // namespace
+
+// ==================== LEXER ====================
+
+void Lexer::lex(std::string_view raw, LexedLine& out)
+{
+    out.tokens.clear();
+
+    // La salida nunca es más larga que la entrada; +16 de holgura para la escritura SIMD
+    out.text.resize(raw.size() + 16);
+    char* const base = &out.text[0];
+    char* dst = base;
+
+    const char* src = raw.data();
+    const char* const end = src + raw.size();
+
+    bool inQuotes = false;
+    bool inToken = false;
+    Token current;
+
+    auto isWord = [base](const Token& token, std::string_view word) {
+        return std::string_view(base + token.begin, token.length) == word;
+    };
+
+    // Un conector solo se elimina si no es la primera palabra; "y"/"con" tampoco
+    // si son la última (equivale a buscar " y " y " con " en la línea).
+    auto beginToken = [&](bool quoted) {
+        if (out.tokens.size() >= 2) {
+            const Token& prev = out.tokens.back();
+            if (prev.kind != TokenKind::String && (isWord(prev, "y") || isWord(prev, "con"))) {
+                dst = base + prev.begin - 1;    // incluye el espacio previo
+                out.tokens.pop_back();
+            }
+        }
+        if (!out.tokens.empty()) *dst++ = ' ';
+        current.begin = std::size_t(dst - base);
+        current.kind = quoted ? TokenKind::String : TokenKind::Other;
+        inToken = true;
+    };
+
+    auto endToken = [&]() {
+        current.length = std::size_t(dst - base) - current.begin;
+        inToken = false;
+        const bool dropped = (current.length == 0) ||
+            (current.kind != TokenKind::String && !out.tokens.empty() && isWord(current, "elementos"));
+        if (dropped) {
+            dst = base + current.begin - (out.tokens.empty() ? 0 : 1);
+            return;
+        }
+        if (current.kind != TokenKind::String) current.kind = classify(base + current.begin, current.length);
+        out.tokens.push_back(current);
+    };
+
+    while (src < end) {
+        const unsigned char c = static_cast<unsigned char>(*src);
+
+        // Dentro de comillas todo se copia sin cambios (un byte de continuación
+        // UTF-8 nunca es '"')
+        if (inQuotes) {
+            *dst++ = char(c);
+            ++src;
+            if (c == '"') inQuotes = false;
+            continue;
+        }
+
+#ifdef NL2CPP_LEXER_SSE2
+        // Camino rápido: tramos de ASCII imprimible, 16 bytes por iteración
+        if (end - src >= 16 && c > 0x20 && c < 0x7F && c != '"') {
+            if (!inToken) beginToken(false);
+            const int n = lowerAsciiRun(src, dst);
+            dst += n;
+            src += n;
+            continue;
+        }
+#endif
+
+        char32_t code;
+        const int length = Utf8::decode(src, end, code);
+
+        if (Utf8::isSpace(code)) {
+            src += length;
+            if (inToken) endToken();
+            continue;
+        }
+
+        if (!inToken) beginToken(c == '"');
+
+        if (c == '"') {
+            inQuotes = true;
+            *dst++ = '"';
+        }
+        else if (code == Utf8::invalid) {
+            *dst++ = char(c);
+        }
+        else if (!isDroppedMark(code)) {
+            dst += Utf8::encode(foldChar(code), dst);
+        }
+        src += length;
+    }
+
+    if (inToken) endToken();
+
+    out.text.resize(std::size_t(dst - base));
+}
+
+void Lexer::splitToken(LexedLine& line, std::size_t offset)
+{
+    for (std::size_t i = 0; i < line.tokens.size(); ++i) {
+        Token& token = line.tokens[i];
+        const std::size_t end = token.begin + token.length;
+        if (offset <= token.begin || offset >= end) continue;
+
+        Token rest;
+        rest.begin = (line.text[offset] == ':' || line.text[offset] == ',') ? offset + 1 : offset;
+        rest.length = end - rest.begin;
+
+        token.length = offset - token.begin;
+        token.kind = classify(line.text.data() + token.begin, token.length);
+        if (rest.length > 0) {
+            rest.kind = (line.text[rest.begin] == '"') ? TokenKind::String
+                                                       : classify(line.text.data() + rest.begin, rest.length);
+            line.tokens.insert(line.tokens.begin() + std::ptrdiff_t(i) + 1, rest);
+        }
+        return;
+    }
+}
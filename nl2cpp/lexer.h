@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "interner.h"
+
+// Clase de un token; el lexer la calcula una sola vez, al cerrarlo
+enum class TokenKind : std::uint8_t {
+    Other,          // operadores, puntuación, palabras con letras no ASCII...
+    Identifier,     // [a-z_][a-z0-9_]*
+    Keyword,        // identificador reservado: tipos y "crear lista de ... elementos"
+    Integer,        // [+-]?[0-9]+
+    Decimal,        // número con punto decimal o exponente
+    String          // literal entre comillas (se conserva tal cual)
+};
+
+// Token: rango de bytes [begin, begin + length) dentro del texto normalizado de la línea
+struct Token {
+    std::size_t begin = 0;
+    std::size_t length = 0;
+    TokenKind kind = TokenKind::Other;
+    SymbolId symbol = NoSymbol; // palabra internada (lo asigna el parser)
+
+    bool isWord() const { return kind == TokenKind::Identifier || kind == TokenKind::Keyword; }
+    bool isNumber() const { return kind == TokenKind::Integer || kind == TokenKind::Decimal; }
+};
+
+// Línea ya normalizada (UTF-8) y sus tokens
+struct LexedLine {
+    std::string text;
+    std::vector<Token> tokens;
+
+    std::string_view token(size_t i) const {
+        return std::string_view(text).substr(tokens[i].begin, tokens[i].length);
+    }
+};
+
+// Normalizador y tokenizador en una sola pasada sobre texto UTF-8.
+//
+// Fuera de comillas: pasa a minúsculas, quita tildes/diéresis de las vocales,
+// elimina los conectores "y", "con" y "elementos" y colapsa los espacios.
+// Un literal entre comillas forma un solo token y no se modifica.
+// Los tokens son rangos sobre 'text', sin crear un string por palabra, y
+// llevan su clase (TokenKind) para que nadie más tenga que revalidarlos.
+// Los bytes que no forman UTF-8 válido se copian sin cambios.
+class Lexer
+{
+public:
+    static void lex(std::string_view raw, LexedLine& out);
+
+    // Parte en 'offset' el token que lo contiene (una frase clave pegada a lo
+    // que sigue: "si(x"). Un ':' o ',' en 'offset' separa y se descarta.
+    static void splitToken(LexedLine& line, std::size_t offset);
+};
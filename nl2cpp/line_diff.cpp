@@ -0,0 +1,113 @@
+﻿#include "stdafx.h"
+#include "line_diff.h"
+
+#include <QHash>
+#include <algorithm>
+
+// ==================== LÍNEAS ====================
+
+std::vector<QStringView> LineDiff::splitLines(QStringView text)
+{
+    std::vector<QStringView> lines;
+    qsizetype start = 0;
+    while (start < text.size()) {
+        const qsizetype newline = text.indexOf(u'\n', start);
+        const qsizetype end = newline < 0 ? text.size() : newline + 1;
+        lines.push_back(text.mid(start, end - start));
+        start = end;
+    }
+    return lines;
+}
+
+// ==================== DIFERENCIA ====================
+
+std::vector<LineHunk> LineDiff::compute(const std::vector<QStringView>& before,
+                                        const std::vector<QStringView>& after,
+                                        int maxEdits)
+{
+    std::vector<LineHunk> hunks;
+
+    // Prefijo y sufijo comunes: lo habitual es que cambien unas pocas líneas seguidas
+    const qsizetype oldTotal = qsizetype(before.size());
+    const qsizetype newTotal = qsizetype(after.size());
+    qsizetype prefix = 0;
+    while (prefix < oldTotal && prefix < newTotal && before[prefix] == after[prefix]) ++prefix;
+    qsizetype suffix = 0;
+    while (suffix < oldTotal - prefix && suffix < newTotal - prefix &&
+           before[oldTotal - 1 - suffix] == after[newTotal - 1 - suffix]) {
+        ++suffix;
+    }
+
+    const int n = int(oldTotal - prefix - suffix);
+    const int m = int(newTotal - prefix - suffix);
+    if (n == 0 && m == 0) return hunks;
+
+    // Las comparaciones del algoritmo van primero por hash
+    std::vector<size_t> oldHashes(n);
+    std::vector<size_t> newHashes(m);
+    for (int i = 0; i < n; ++i) oldHashes[i] = qHash(before[prefix + i]);
+    for (int j = 0; j < m; ++j) newHashes[j] = qHash(after[prefix + j]);
+    auto same = [&](int x, int y) {
+        return oldHashes[x] == newHashes[y] && before[prefix + x] == after[prefix + y];
+    };
+
+    // Myers: V[k] es la x más lejana alcanzada en la diagonal k = x - y con d
+    // ediciones. 'trace' guarda V[-d..d] de cada paso para reconstruir el camino.
+    const int limit = std::min(maxEdits, n + m);
+    std::vector<int> v(2 * std::size_t(limit) + 3, 0);
+    const int center = limit + 1;
+    std::vector<int> trace;
+    int edits = -1;
+
+    for (int d = 0; d <= limit && edits < 0; ++d) {
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[center + k - 1] < v[center + k + 1]))
+                ? v[center + k + 1]             // inserción (baja)
+                : v[center + k - 1] + 1;        // borrado (avanza)
+            int y = x - k;
+            while (x < n && y < m && same(x, y)) { ++x; ++y; }
+            v[center + k] = x;
+            if (x >= n && y >= m) edits = d;
+        }
+        trace.insert(trace.end(), v.begin() + center - d, v.begin() + center + d + 1);
+    }
+
+    // Demasiados cambios: un solo reemplazo de todo el tramo central
+    if (edits < 0) {
+        hunks.push_back({ prefix, n, prefix, m });
+        return hunks;
+    }
+
+    // Recorrido hacia atrás: tramos diagonales (líneas iguales), del último al primero
+    struct Run { int x; int y; int length; };
+    std::vector<Run> runs;
+    int x = n;
+    int y = m;
+    for (int d = edits; d > 0; --d) {
+        const int k = x - y;
+        const int* previous = trace.data() + std::size_t(d - 1) * std::size_t(d - 1) + (d - 1);   // V[0] del paso d - 1
+        const bool down = k == -d || (k != d && previous[k - 1] < previous[k + 1]);
+        const int previousK = down ? k + 1 : k - 1;
+        const int previousX = previous[previousK];
+        const int startX = down ? previousX : previousX + 1;
+        if (x > startX) runs.push_back({ startX, startX - k, x - startX });
+        x = previousX;
+        y = previousX - previousK;
+    }
+    if (x > 0) runs.push_back({ 0, 0, x });
+
+    // Los huecos entre tramos iguales son los cambios
+    int oldPos = 0;
+    int newPos = 0;
+    for (auto run = runs.rbegin(); run != runs.rend(); ++run) {
+        if (run->x > oldPos || run->y > newPos) {
+            hunks.push_back({ prefix + oldPos, run->x - oldPos, prefix + newPos, run->y - newPos });
+        }
+        oldPos = run->x + run->length;
+        newPos = run->y + run->length;
+    }
+    if (oldPos < n || newPos < m) {
+        hunks.push_back({ prefix + oldPos, n - oldPos, prefix + newPos, m - newPos });
+    }
+    return hunks;
+}
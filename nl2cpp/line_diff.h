@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <QStringView>
+#include <vector>
+
+// Tramo que cambia entre dos textos: las líneas [oldFirst, oldFirst + oldCount)
+// del anterior se reemplazan por [newFirst, newFirst + newCount) del nuevo
+struct LineHunk {
+    qsizetype oldFirst = 0;
+    qsizetype oldCount = 0;
+    qsizetype newFirst = 0;
+    qsizetype newCount = 0;
+};
+
+// Diferencia por líneas (Myers) entre dos textos, para actualizar un documento
+// con unas pocas ediciones en lugar de reemplazarlo entero. Antes de comparar
+// se descartan el prefijo y el sufijo comunes, así que el costo depende sobre
+// todo de lo que cambió.
+class LineDiff
+{
+public:
+    // Líneas con su '\n' final (la última puede no tenerlo); son vistas sobre 'text'
+    static std::vector<QStringView> splitLines(QStringView text);
+
+    // Tramos distintos, en orden. Si hay más de 'maxEdits' líneas insertadas o
+    // borradas, devuelve un solo tramo con todo lo que queda entre el prefijo y
+    // el sufijo comunes.
+    static std::vector<LineHunk> compute(const std::vector<QStringView>& before,
+                                         const std::vector<QStringView>& after,
+                                         int maxEdits = 1000);
+};
@@ -0,0 +1,25 @@
+﻿#include "stdafx.h"
+#include "line_reader.h"
+
+// ==================== TEXTO EN MEMORIA ====================
+
+bool StringLineReader::readLine(std::string_view& line)
+{
+    if (pos >= text.size()) return false;
+
+    std::size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) end = text.size();
+
+    line = text.substr(pos, end - pos);
+    pos = end + 1;
+    return true;
+}
+
+// ==================== STD::ISTREAM ====================
+
+bool StdStreamLineReader::readLine(std::string_view& line)
+{
+    if (!std::getline(stream, buffer)) return false;
+    line = buffer;
+    return true;
+}
@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Fuente de líneas UTF-8 para el procesador: entrega una línea cruda a la vez
+// (sin el salto de línea), de modo que la entrada nunca se copia completa.
+class LineReader
+{
+public:
+    virtual ~LineReader() = default;
+
+    // Apunta 'line' a la siguiente línea; la vista vale hasta la próxima llamada.
+    // Devuelve false al llegar al final de la entrada.
+    virtual bool readLine(std::string_view& line) = 0;
+
+    // Vuelve al principio de la entrada, si la fuente lo permite (texto en
+    // memoria, archivo proyectado). Devuelve false si no se puede releer.
+    virtual bool rewind() { return false; }
+};
+
+// Recorre un texto ya cargado en memoria: cada línea es una vista sobre 'text',
+// sin copias
+class StringLineReader : public LineReader
+{
+public:
+    explicit StringLineReader(std::string_view text) : text(text) {}
+    bool readLine(std::string_view& line) override;
+    bool rewind() override { pos = 0; return true; }
+
+private:
+    std::string_view text;
+    std::size_t pos = 0;
+};
+
+// Lee líneas UTF-8 de un std::istream
+class StdStreamLineReader : public LineReader
+{
+public:
+    explicit StdStreamLineReader(std::istream& stream) : stream(stream) {}
+    bool readLine(std::string_view& line) override;
+
+private:
+    std::istream& stream;
+    std::string buffer;
+};
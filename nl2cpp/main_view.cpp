@@ -1,10 +1,107 @@
 ﻿#include "stdafx.h"
 #include "main_view.h"
+#include "line_diff.h"
+#include "qt_adapter.h"
 
 #include <QFileDialog>
 #include <QFile>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTimer>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+// A partir de estas líneas un panel deja de usar el editor y pasa a la vista
+// virtualizada: la maquetación completa de QTextEdit bloquea la interfaz
+constexpr qsizetype largeDocumentLines = 20000;
+
+bool isLargeDocument(const QString& text)
+{
+    return text.count(u'\n') >= largeDocumentLines;
+}
+
+// Sin nada más que espacios; casi siempre basta con mirar el primer bloque
+bool isBlank(const QTextDocument* document)
+{
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        if (!block.text().trimmed().isEmpty()) return false;
+    }
+    return true;
+}
+
+// El mismo texto que daría QTextDocument::toPlainText para esas líneas
+QString plainText(QString text)
+{
+    for (QChar& c : text) {
+        if (c == QChar::LineSeparator || c == QChar::ParagraphSeparator) c = u'\n';
+        else if (c == QChar::Nbsp) c = u' ';
+    }
+    return text;
+}
+
+// Lleva 'editor' a 'text' con unas pocas ediciones (ver LineDiff) en lugar de
+// setPlainText: solo se maquetan de nuevo las líneas que cambiaron y se
+// conservan el desplazamiento y el cursor
+void updatePlainText(QTextEdit* editor, const QString& text)
+{
+    QTextDocument* document = editor->document();
+    if (document->isEmpty()) {
+        editor->setPlainText(text);
+        return;
+    }
+
+    const QString previous = document->toPlainText();
+    const std::vector<QStringView> before = LineDiff::splitLines(previous);
+    const std::vector<QStringView> after = LineDiff::splitLines(text);
+    const std::vector<LineHunk> hunks = LineDiff::compute(before, after);
+    if (hunks.empty()) return;
+
+    auto offset = [](const std::vector<QStringView>& lines, const QString& whole, qsizetype line) {
+        return line < qsizetype(lines.size()) ? qsizetype(lines[line].data() - whole.data()) : whole.size();
+    };
+
+    // Como con setPlainText, las ediciones no quedan en el historial de deshacer
+    document->setUndoRedoEnabled(false);
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+
+    // Del último tramo al primero: las posiciones de los anteriores no cambian
+    for (auto hunk = hunks.rbegin(); hunk != hunks.rend(); ++hunk) {
+        cursor.setPosition(int(offset(before, previous, hunk->oldFirst)));
+        cursor.setPosition(int(offset(before, previous, hunk->oldFirst + hunk->oldCount)), QTextCursor::KeepAnchor);
+
+        const qsizetype from = offset(after, text, hunk->newFirst);
+        const qsizetype to = offset(after, text, hunk->newFirst + hunk->newCount);
+        if (from == to) cursor.removeSelectedText();
+        else cursor.insertText(text.mid(from, to - from));
+    }
+
+    cursor.endEditBlock();
+    document->setUndoRedoEnabled(true);
+
+    // toPlainText normaliza algunos separadores; si el resultado no cuadra, se reemplaza entero
+    if (document->characterCount() != text.size() + 1) editor->setPlainText(text);
+}
+
+// Lleva el avance del parser a la barra de progreso y la cancelación pedida
+// desde la interfaz al conversor
+class PromiseObserver : public ConversionObserver
+{
+public:
+    explicit PromiseObserver(QPromise<QString>& promise) : promise(promise) {}
+
+    void linesParsed(int count) override { promise.setProgressValue(count); }
+    bool isCancelled() const override { return promise.isCanceled(); }
+
+private:
+    QPromise<QString>& promise;
+};
+}
 
 // Constructor
 MainView::MainView(QWidget* parent)
@@ -17,11 +114,36 @@ MainView::MainView(QWidget* parent)
     connect(ui.btnClean, &QPushButton::clicked, this, &MainView::onBtnCleanClicked);
     connect(ui.btnConvert, &QPushButton::clicked, this, &MainView::onBtnConvertClicked);
     connect(ui.btnSave, &QPushButton::clicked, this, &MainView::onBtnSaveClicked);
+
+    // Conversión en vivo. La entrada es texto plano: cada bloque es una línea
+    ui.txtEdtLoaded->setAcceptRichText(false);
+    connect(ui.chkLive, &QCheckBox::toggled, this, &MainView::onChkLiveToggled);
+    connect(ui.txtEdtLoaded, &QTextEdit::textChanged, this, &MainView::onInputChanged);
+    connect(ui.txtEdtLoaded->document(), &QTextDocument::contentsChange, this, &MainView::onInputContentsChange);
+
+    // Trabajo en segundo plano
+    connect(ui.btnCancel, &QPushButton::clicked, this, &MainView::onBtnCancelClicked);
+    connect(&conversionWatcher, &QFutureWatcherBase::progressRangeChanged, ui.progressBar, &QProgressBar::setRange);
+    connect(&conversionWatcher, &QFutureWatcherBase::progressValueChanged, ui.progressBar, &QProgressBar::setValue);
+    connect(&conversionWatcher, &QFutureWatcherBase::finished, this, &MainView::onConversionFinished);
+    connect(&loadWatcher, &QFutureWatcherBase::finished, this, &MainView::onFileLoaded);
+    connect(&saveWatcher, &QFutureWatcherBase::finished, this, &MainView::onFileSaved);
+
+    // Un documento grande no se puede editar: la vista solo pinta las líneas visibles
+    ui.viewLoaded->setToolTip(tr("Los documentos de %1 líneas o más se muestran en una vista "
+                                 "de solo lectura.").arg(largeDocumentLines));
+
+    converter.setStats(&conversionStats);
+    setBusy(false);
 }
 
-// Destructor
+// Destructor: el hilo de trabajo usa 'converter', hay que esperarlo
 MainView::~MainView()
 {
+    conversionWatcher.cancel();
+    conversionWatcher.waitForFinished();
+    loadWatcher.waitForFinished();
+    saveWatcher.waitForFinished();
 }
 
 // ==================== SLOTS ====================
@@ -42,21 +164,20 @@ void MainView::onBtnLoadClicked()
 
 void MainView::onBtnCleanClicked()
 {
-    ui.txtEdtLoaded->clear();
-    ui.txtEdtConverted->clear();
+    setInputText(QString());
+    setOutputText(QString());
 }
 
 void MainView::onBtnConvertClicked()
 {
-    QString input = ui.txtEdtLoaded->toPlainText();
+    QString input = inputText();
 
     if (input.trimmed().isEmpty()) {
         QMessageBox::warning(this, tr("Advertencia"), tr("El texto de entrada está vacío."));
         return;
     }
 
-    QString output = convertText(input);
-    ui.txtEdtConverted->setPlainText(output);
+    startConversion(input);
 }
 
 void MainView::onBtnSaveClicked()
@@ -73,37 +194,273 @@ void MainView::onBtnSaveClicked()
     }
 }
 
-// ==================== MÉTODOS AUXILIARES ====================
+void MainView::onChkLiveToggled(bool checked)
+{
+    if (checked) {
+        refreshLiveOutput();
+    }
+    else {
+        liveConverter.reset();  // libera la caché
+        liveSynced = false;
+    }
+}
 
-void MainView::loadFromFile(const QString& filePath)
+// Varias ediciones dentro de una misma vuelta del bucle de eventos
+// (pegar, deshacer...) se agrupan en una sola reconversión
+void MainView::onInputChanged()
+{
+    if (!ui.chkLive->isChecked() || liveUpdatePending) return;
+
+    liveUpdatePending = true;
+    QTimer::singleShot(0, this, &MainView::refreshLiveOutput);
+}
+
+// Junta el tramo de líneas editado hasta la próxima reconversión. Lo anterior
+// a 'position' y lo posterior al texto insertado no cambió, así que el tramo
+// se cuenta desde cada extremo y sigue valiendo tras varias ediciones.
+void MainView::onInputContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (!liveSynced) return;
+
+    const QTextDocument* document = ui.txtEdtLoaded->document();
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid()) last = document->lastBlock();
+    const int first = qMax(0, document->findBlock(position).blockNumber());
+    const int fromEnd = document->blockCount() - 1 - last.blockNumber();
+
+    if (liveDirtyFirst < 0) {
+        liveDirtyFirst = first;
+        liveDirtyFromEnd = fromEnd;
+    }
+    else {
+        liveDirtyFirst = qMin(liveDirtyFirst, first);
+        liveDirtyFromEnd = qMin(liveDirtyFromEnd, fromEnd);
+    }
+}
+
+void MainView::onBtnCancelClicked()
+{
+    // El parser y el generador lo comprueban entre líneas e instrucciones
+    conversionWatcher.cancel();
+    ui.btnCancel->setEnabled(false);
+}
+
+void MainView::onConversionFinished()
+{
+    setBusy(false);
+
+    // Una conversión cancelada queda incompleta: se descarta
+    if (conversionWatcher.isCanceled() || conversionWatcher.future().resultCount() == 0) {
+        statusBar()->showMessage(tr("Conversión cancelada."), 3000);
+        return;
+    }
+
+    setOutputText(conversionWatcher.result());
+
+    // Resumen en la barra de estado; el detalle por etapa y tipo, en su tooltip
+    statusBar()->showMessage(QString::fromStdString(conversionStats.summary()));
+    statusBar()->setToolTip(QString::fromStdString(conversionStats.report()));
+}
+
+void MainView::onFileLoaded()
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    setBusy(false);
+
+    const FileResult result = loadWatcher.result();
+    if (!result.ok) {
         QMessageBox::critical(this, tr("Error"), tr("No se pudo abrir el archivo."));
         return;
     }
 
-    QTextStream in(&file);
-    QString content = in.readAll();
-    ui.txtEdtLoaded->setPlainText(content);
-    file.close();
+    setInputText(result.content);
 }
 
-void MainView::saveToFile(const QString& filePath)
+void MainView::onFileSaved()
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    setBusy(false);
+
+    if (!saveWatcher.result().ok) {
         QMessageBox::critical(this, tr("Error"), tr("No se pudo guardar el archivo."));
+    }
+}
+
+// ==================== MÉTODOS AUXILIARES ====================
+
+void MainView::loadFromFile(const QString& filePath)
+{
+    setBusy(true);
+    ui.btnCancel->setEnabled(false);    // la lectura no se puede interrumpir
+
+    loadWatcher.setFuture(QtConcurrent::run([filePath] {
+        FileResult result;
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            // Proyectado en memoria: el texto se arma una sola vez, línea a línea,
+            // sin pasar por un QByteArray ni por el buffer de QTextStream. Como
+            // con readAll, el '\n' final solo está si el archivo lo tenía.
+            MappedLineReader reader(file);
+            result.content.reserve(qsizetype(file.size()));
+            std::string_view line;
+            while (reader.readLine(line)) {
+                result.content += QUtf8StringView(line.data(), qsizetype(line.size()));
+                if (reader.lineEnded()) result.content += u'\n';
+            }
+            result.ok = true;
+        }
+        return result;
+    }));
+}
+
+void MainView::saveToFile(const QString& filePath)
+{
+    setBusy(true);
+    ui.btnCancel->setEnabled(false);
+
+    // El texto se toma aquí, en el hilo de la interfaz; solo la escritura va al hilo de trabajo
+    saveWatcher.setFuture(QtConcurrent::run([filePath, content = outputText()] {
+        FileResult result;
+        QFile file(filePath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QTextStream out(&file);
+            out << content;
+            out.flush();
+            result.ok = out.status() == QTextStream::Ok;
+        }
+        return result;
+    }));
+}
+
+void MainView::startConversion(const QString& input)
+{
+    setBusy(true);
+
+    // La barra avanza con las líneas leídas por el parser
+    const int lines = int(input.count(u'\n')) + 1;
+
+    conversionWatcher.setFuture(QtConcurrent::run([this, lines](QPromise<QString>& promise, const QString& text) {
+        promise.setProgressRange(0, lines);
+
+        PromiseObserver observer(promise);
+        conversionStats.clear();
+        QString output = QtAdapter::convert(converter, text, observer);
+
+        if (!promise.isCanceled()) {
+            promise.setProgressValue(lines);
+            promise.addResult(std::move(output));
+        }
+    }, input));
+}
+
+// Mientras hay trabajo en segundo plano solo se puede cancelar
+void MainView::setBusy(bool busy)
+{
+    ui.btnLoad->setEnabled(!busy);
+    ui.btnClean->setEnabled(!busy);
+    ui.btnConvert->setEnabled(!busy);
+    ui.btnSave->setEnabled(!busy);
+
+    ui.progressBar->setVisible(busy);
+    ui.btnCancel->setVisible(busy);
+    ui.btnCancel->setEnabled(busy);
+
+    // Sin avance conocido (archivos) la barra queda indeterminada
+    ui.progressBar->setRange(0, 0);
+}
+
+void MainView::refreshLiveOutput()
+{
+    liveUpdatePending = false;
+    if (!ui.chkLive->isChecked()) return;
+
+    const QTextDocument* document = ui.txtEdtLoaded->document();
+    const bool inEditor = ui.stkLoaded->currentWidget() == ui.txtEdtLoaded;
+    if (inEditor ? isBlank(document) : inputText().trimmed().isEmpty()) {
+        liveSynced = false;
+        liveDirtyFirst = -1;
+        setOutputText(QString());
         return;
     }
+    if (inEditor && liveSynced && liveDirtyFirst < 0) return;  // el texto no cambió
 
-    QTextStream out(&file);
-    out << ui.txtEdtConverted->toPlainText();
-    file.close();
+    // Solo las líneas editadas: el editor no se copia entero en cada tecla
+    const int first = liveDirtyFirst;
+    const int newCount = document->blockCount() - liveDirtyFromEnd - first;
+    const int oldCount = liveConverter.lineCount() - liveDirtyFromEnd - first;
+    const std::string* code = nullptr;
+    if (inEditor && liveSynced && newCount > 0 && oldCount > 0) {
+        QString lines;
+        QTextBlock block = document->findBlockByNumber(first);
+        for (int i = 0; i < newCount; ++i, block = block.next()) {
+            if (i) lines += u'\n';
+            lines += block.text();
+        }
+        code = &liveConverter.replaceLines(first, oldCount, QtAdapter::toUtf8(plainText(std::move(lines))));
+    }
+    else {
+        code = &liveConverter.update(QtAdapter::toUtf8(inputText()));
+    }
+
+    // Un separador de línea dentro de un bloque (Mayús+Intro) rompe la
+    // correspondencia línea-bloque: hasta que desaparezca, texto completo
+    liveSynced = inEditor && document->blockCount() == liveConverter.lineCount();
+    liveDirtyFirst = -1;
+
+    setOutputText(QtAdapter::toQString(*code));
+}
+
+// ==================== PANELES ====================
+
+QString MainView::inputText() const
+{
+    if (ui.stkLoaded->currentWidget() == ui.viewLoaded) return ui.viewLoaded->text();
+    return ui.txtEdtLoaded->toPlainText();
+}
+
+void MainView::setInputText(const QString& text)
+{
+    if (isLargeDocument(text)) {
+        ui.txtEdtLoaded->clear();
+        ui.viewLoaded->setText(text);
+        ui.stkLoaded->setCurrentWidget(ui.viewLoaded);
+        statusBar()->showMessage(tr("Documento de %1 líneas: se muestra en solo lectura y no se puede editar.")
+                                     .arg(ui.viewLoaded->lineCount()));
+    }
+    else {
+        ui.viewLoaded->clear();
+        ui.txtEdtLoaded->setPlainText(text);
+        ui.stkLoaded->setCurrentWidget(ui.txtEdtLoaded);
+    }
+}
+
+QString MainView::outputText() const
+{
+    if (ui.stkConverted->currentWidget() == ui.viewConverted) return ui.viewConverted->text();
+    return ui.txtEdtConverted->toPlainText();
+}
+
+// Tanto en vivo como con Convertir se conserva la posición de lectura, también
+// si la salida pasa de un panel al otro (en los dos la barra cuenta líneas)
+void MainView::setOutputText(const QString& text)
+{
+    const int position = outputPane()->verticalScrollBar()->value();
+
+    if (isLargeDocument(text)) {
+        const bool showing = ui.stkConverted->currentWidget() == ui.viewConverted;
+        ui.txtEdtConverted->clear();
+        if (showing) ui.viewConverted->updateText(text);
+        else ui.viewConverted->setText(text);
+        ui.stkConverted->setCurrentWidget(ui.viewConverted);
+    }
+    else {
+        ui.viewConverted->clear();
+        updatePlainText(ui.txtEdtConverted, text);
+        ui.stkConverted->setCurrentWidget(ui.txtEdtConverted);
+    }
+    outputPane()->verticalScrollBar()->setValue(position);
 }
 
-QString MainView::convertText(const QString& input)
+QAbstractScrollArea* MainView::outputPane() const
 {
-    // 🔹 Ahora usamos la clase Converter en lugar del mock
-    return converter.convert(input);
+    return static_cast<QAbstractScrollArea*>(ui.stkConverted->currentWidget());
 }
@@ -2,8 +2,11 @@
 
 #include <QtWidgets/QMainWindow>
 #include <QString>
+#include <QFutureWatcher>
 #include "ui_main_view.h"
 #include "converter.h"
+#include "incremental_converter.h"
+#include "conversion_stats.h"
 
 class MainView : public QMainWindow
 {
@@ -18,13 +21,54 @@ private slots:
     void onBtnCleanClicked();
     void onBtnConvertClicked();
     void onBtnSaveClicked();
+    void onChkLiveToggled(bool checked);
+    void onInputChanged();
+    void onInputContentsChange(int position, int charsRemoved, int charsAdded);
+    void onBtnCancelClicked();
+    void onConversionFinished();
+    void onFileLoaded();
+    void onFileSaved();
 
 private:
     Ui::MainViewClass ui;
+
+    // Resultado de una lectura o escritura hecha en segundo plano
+    struct FileResult {
+        QString content;
+        bool ok = false;
+    };
+
+    // Conversin y E/S de archivos en un hilo de trabajo; los watchers
+    // entregan el avance y el resultado en el hilo de la interfaz.
+    // 'converter' solo lo usa la conversin en curso (hay una a la vez).
     Converter converter;
+    ConversionStats conversionStats;    // mtricas de la ltima conversin
+    QFutureWatcher<QString> conversionWatcher;
+    QFutureWatcher<FileResult> loadWatcher;
+    QFutureWatcher<FileResult> saveWatcher;
+
+    // Modo en vivo: reconvierte solo las unidades modificadas. Con
+    // 'liveSynced', liveConverter tiene el texto del editor lnea por bloque y
+    // solo recibe las lneas editadas desde entonces: de 'liveDirtyFirst'
+    // (-1 = ninguna) hasta 'liveDirtyFromEnd' lneas antes del final.
+    IncrementalConverter liveConverter;
+    bool liveUpdatePending = false;
+    bool liveSynced = false;
+    int liveDirtyFirst = -1;
+    int liveDirtyFromEnd = 0;
 
     // Mtodos auxiliares
     void loadFromFile(const QString& filePath);
     void saveToFile(const QString& filePath);
-    QString convertText(const QString& input);
+    void startConversion(const QString& input);
+    void setBusy(bool busy);
+    void refreshLiveOutput();
+
+    // Texto de los paneles. Un documento enorme se muestra en la vista
+    // virtualizada (solo lectura); uno normal, en el editor.
+    QString inputText() const;
+    void setInputText(const QString& text);
+    QString outputText() const;
+    void setOutputText(const QString& text);
+    QAbstractScrollArea* outputPane() const;
 };
@@ -1,338 +1,349 @@
 ﻿#include "stdafx.h"
 #include "natural_language_processor.h"
-#include <QStringList>
+#include "conversion_stats.h"
 
 // ==================== CONSTRUCTOR ====================
-NaturalLanguageProcessor::NaturalLanguageProcessor()
-{
-    initializeDictionaries();
-}
+NaturalLanguageProcessor::NaturalLanguageProcessor() {}
 
 NaturalLanguageProcessor::~NaturalLanguageProcessor() {}
 
-// ==================== MÉTODO PRINCIPAL ====================
+// ==================== LECTURA DE LÍNEAS ====================
 
-std::vector<Instruction> NaturalLanguageProcessor::processText(const QString& inputText)
+// Normaliza y tokeniza cada línea en una sola pasada (ver Lexer) y clasifica
+// su frase inicial una sola vez; el parser solo consulta 'match'.
+// Si el observador pide cancelar, la entrada se da por terminada: todos los
+// niveles del parser ven atEnd() y vuelven sin más trabajo.
+void NaturalLanguageProcessor::LineCursor::advance()
 {
-    QStringList lines = inputText.split("\n", Qt::SkipEmptyParts);
-
-    for (QString& line : lines) {
-        line = line.trimmed();
-
-        // 1. Preservar literales entre comillas
-        QString preserved;
-        bool insideQuotes = false;
-        for (int i = 0; i < line.size(); ++i) {
-            QChar c = line[i];
-            if (c == '\"') {
-                insideQuotes = !insideQuotes;
-                preserved.append(c);
-            }
-            else {
-                if (insideQuotes) {
-                    // dentro de comillas: no cambiar mayúsculas
-                    preserved.append(c);
-                }
-                else {
-                    // fuera de comillas: pasar a minúscula
-                    preserved.append(c.toLower());
-                }
-            }
+    std::string_view raw;
+    while (!(observer && observer->isCancelled()) && reader.readLine(raw)) {
+        ++linesRead;
+        if (observer && linesRead % ConversionObserver::reportInterval == 0) {
+            observer->linesParsed(linesRead);
         }
-        line = preserved;
-
-        // 2. Limpieza de conectores fuera de comillas
-        if (!insideQuotes) {
-            line.replace(" y ", " ");
-            line.replace(" con ", " ");
-            line.replace(" elementos", "");
-            // Ojo: ya no borramos " a " ni " que " aquí,
-            // porque forman parte de condiciones y mensajes.
+        if (stats) {
+            const std::int64_t start = ConversionStats::now();
+            Lexer::lex(raw, lexed);
+            lexNs += ConversionStats::now() - start;
+        }
+        else {
+            Lexer::lex(raw, lexed);
+        }
+        if (!lexed.tokens.empty()) {
+            match = KeywordTable::match(lexed.text);
+            // "si(x > 3)", "mostrar: x": la frase clave pasa a ser un token propio
+            if (match && match.length < lexed.text.size() && lexed.text[match.length] != ' ') {
+                Lexer::splitToken(lexed, match.length);
+            }
+            line = linesRead - 1;
+            valid = true;
+            return;
         }
-
-        // 3. Normalizaciones mínimas de acentos
-        line.replace("número", "numero");
-        line.replace("carácter", "caracter");
     }
+    line = linesRead;
+    lexed.text.resize(0);      // conserva la capacidad para la próxima conversión
+    lexed.tokens.clear();
+    match = PhraseMatch();
+    valid = false;
+}
+
+// ==================== MÉTODO PRINCIPAL ====================
 
-    int index = 0;
-    return parseBlock(lines, index);
+Program NaturalLanguageProcessor::processText(std::string_view inputText)
+{
+    StringLineReader reader(inputText);
+    return processLines(reader);
 }
 
+Program NaturalLanguageProcessor::processStream(std::istream& stream)
+{
+    StdStreamLineReader reader(stream);
+    return processLines(reader);
+}
 
-// ==================== PARSER DE BLOQUES ====================
-// Parsea hasta encontrar alguno de los stopTokens SIN consumirlo.
-std::vector<Instruction> NaturalLanguageProcessor::parseUntil(const QStringList& lines, int& index, const QStringList& stopTokens)
+// Solo se mantiene en memoria la línea actual: cada línea se tokeniza al leerla
+// y se entrega directamente al parser.
+Program NaturalLanguageProcessor::processLines(LineReader& reader)
+{
+    Program program;
+    processLines(reader, program);
+    return program;
+}
+
+void NaturalLanguageProcessor::processLines(LineReader& reader, Program& program)
 {
-    std::vector<Instruction> block;
+    const std::int64_t start = stats ? ConversionStats::now() : 0;
 
-    while (index < lines.size()) {
-        QString line = lines[index];
-        if (line.isEmpty()) { index++; continue; }
+    program.clear();
+    LineCursor cursor(reader, lexedLine, observer, stats);
 
-        // ¿Debemos detenernos aquí?
-        bool shouldStop = false;
-        for (const QString& s : stopTokens) {
-            if (line.startsWith(s)) { shouldStop = true; break; }
-        }
-        if (shouldStop) break;
-
-        // Si aquí empieza otro control, delega a parseBlock para manejar su propio fin
-        if (line.startsWith("si") || line.startsWith("sino") ||
-            line.startsWith("mientras") || line.startsWith("para") ||
-            line.startsWith("repetir hasta")) {
-            // parseBlock devolverá uno o varios instructions (ej. if y luego else)
-            auto sub = parseBlock(lines, index);
-            for (auto& ins : sub) block.push_back(ins);
-            continue;
-        }
+    pending.clear();
+    openBlocks.clear();
+    ParseContext ctx{ cursor, program.arena, program.names, pending, openBlocks };
+
+    parseBlock(ctx);
+    program.instructions = commitPending(ctx, 0);
+    program.textLength = ctx.textLength;
 
-        // Instrucción simple
-        block.push_back(parseLine(line));
-        index++;
+    if (stats) {
+        stats->normalizeNs += cursor.lexNs;
+        stats->parseNs += ConversionStats::now() - start - cursor.lexNs;
+        stats->lines += cursor.linesRead;
+        countInstructions(program.instructions, *stats);
     }
-    return block;
 }
 
-std::vector<Instruction> NaturalLanguageProcessor::parseBlock(const QStringList& lines, int& index)
+// Con una pila propia: el árbol puede ser tan profundo como la entrada
+void NaturalLanguageProcessor::countInstructions(InstructionList instructions, ConversionStats& stats)
 {
-    std::vector<Instruction> block;
+    std::vector<InstructionList> lists{ instructions };
+    while (!lists.empty()) {
+        const InstructionList list = lists.back();
+        lists.pop_back();
+        for (const Instruction& inst : list) {
+            ++stats.instructions[int(inst.type)];
+            if (!inst.nested.empty()) lists.push_back(inst.nested);
+        }
+    }
+}
 
-    while (index < lines.size()) {
-        QString line = lines[index];
+void NaturalLanguageProcessor::processUnits(LineReader& reader, Arena& arena, Interner& names, const UnitCallback& onUnit)
+{
+    LineCursor cursor(reader, lexedLine, observer);
 
-        if (line.isEmpty()) { index++; continue; }
+    pending.clear();
+    openBlocks.clear();
+    ParseContext ctx{ cursor, arena, names, pending, openBlocks };
 
-        // Estos cierran niveles superiores
-        if (line.startsWith("fin si") || line.startsWith("fin mientras") || line.startsWith("fin para")) {
-            index++; // consumir el fin
-            break;
-        }
+    // Mismo recorrido que parseBlock en el nivel superior, entregando cada unidad
+    while (!cursor.atEnd()) {
+        ParsedUnit unit;
+        unit.firstLine = cursor.line;
+        unit.closesProgram = !parseUnit(ctx);
+        unit.instructions = commitPending(ctx, 0);
+        unit.nextLine = cursor.line;
 
-        // ---- IF / ELSE ----
-        if (line.startsWith("si")) {
-            Instruction ifInst = parseLine(line);
-            index++; // avanzar tras 'si ...'
-
-            // Cuerpo del IF: hasta 'sino' o 'fin si'
-            ifInst.nested = parseUntil(lines, index, { "sino", "fin si" });
-            block.push_back(ifInst);
-
-            // ¿Hay 'sino'?
-            if (index < lines.size() && lines[index].startsWith("sino")) {
-                Instruction elseInst = parseLine(lines[index]);
-                index++; // avanzar tras 'sino'
-                // Cuerpo del ELSE: hasta 'fin si'
-                elseInst.nested = parseUntil(lines, index, { "fin si" });
-                block.push_back(elseInst);
-            }
+        if (!onUnit(unit) || unit.closesProgram) return;
+    }
+}
 
-            // Consumir 'fin si' si está presente
-            if (index < lines.size() && lines[index].startsWith("fin si")) {
-                index++;
-            }
-            continue;
-        }
 
-        // ---- WHILE ----
-        if (line.startsWith("mientras")) {
-            Instruction wInst = parseLine(line);
-            index++; // avanzar tras 'mientras ...'
-            wInst.nested = parseUntil(lines, index, { "fin mientras" });
-            block.push_back(wInst);
+// ==================== PARSER DE BLOQUES ====================
 
-            if (index < lines.size() && lines[index].startsWith("fin mientras")) {
-                index++; // cerrar while
-            }
-            continue;
-        }
+namespace {
+// Cierres que terminan una secuencia (y el programa, en el nivel superior)
+bool closesSequence(Phrase phrase)
+{
+    return phrase == Phrase::FinSi || phrase == Phrase::FinMientras || phrase == Phrase::FinPara;
+}
 
-        // ---- FOR ----
-        if (line.startsWith("para")) {
-            Instruction fInst = parseLine(line);
-            index++; // avanzar tras 'para ...'
-            fInst.nested = parseUntil(lines, index, { "fin para" });
-            block.push_back(fInst);
+// Dentro de un cuerpo solo estas frases abren una secuencia; 'repetir' suelto y
+// 'definir funcion' quedan como instrucciones simples del cuerpo
+bool startsSequence(Phrase phrase)
+{
+    return phrase == Phrase::Si || phrase == Phrase::Sino ||
+        phrase == Phrase::Mientras || phrase == Phrase::Para ||
+        phrase == Phrase::RepetirHasta;
+}
+}
 
-            if (index < lines.size() && lines[index].startsWith("fin para")) {
-                index++; // cerrar for
-            }
-            continue;
-        }
+void NaturalLanguageProcessor::parseBlock(ParseContext& ctx)
+{
+    while (!ctx.cursor.atEnd()) {
+        if (!parseUnit(ctx)) return;
+    }
+}
 
-        // ---- DO-WHILE ----
-        if (line.startsWith("repetir")) {
-            Instruction dInst = parseLine(line);
-            index++; // avanzar tras 'repetir'
+// Un solo bucle recorre todo el anidamiento de la unidad: cada línea se
+// visita una vez y cada nivel ocupa una entrada de 'ctx.blocks'
+bool NaturalLanguageProcessor::parseUnit(ParseContext& ctx)
+{
+    LineCursor& cursor = ctx.cursor;
 
-            // cuerpo hasta 'hasta que'
-            dInst.nested = parseUntil(lines, index, { "hasta", "hasta que" });
-            block.push_back(dInst);
+    if (closesSequence(cursor.phrase())) {
+        cursor.advance(); // consumir el fin
+        return false;
+    }
 
-            if (index < lines.size() && (lines[index].startsWith("hasta") || lines[index].startsWith("hasta que"))) {
-                Instruction condInst = parseLine(lines[index]);
-                block.push_back(condInst);
-                index++;
-            }
-            continue;
-        }
+    const std::size_t base = ctx.blocks.size();
+    if (!openBlock(ctx)) {
+        ctx.pending.push_back(parseLine(ctx)); // instrucción simple
+        return true;
+    }
 
-        // ---- FUNCTION DECLARATION ----
-        if (line.startsWith("definir funcion")) {
-            Instruction funInst = parseLine(line);
-            index++;
-            funInst.nested = parseUntil(lines, index, { "fin funcion" });
-            block.push_back(funInst);
+    while (ctx.blocks.size() > base) {
+        const OpenBlock& block = ctx.blocks.back();
 
-            if (index < lines.size() && lines[index].startsWith("fin funcion")) {
-                index++;
+        // Secuencia: unidades hasta un cierre, que se consume
+        if (block.kind == BlockKind::Sequence) {
+            if (cursor.atEnd()) {
+                ctx.blocks.pop_back();
+            }
+            else if (closesSequence(cursor.phrase())) {
+                cursor.advance();
+                ctx.blocks.pop_back();
+            }
+            else if (!openBlock(ctx)) {
+                ctx.pending.push_back(parseLine(ctx));
             }
             continue;
         }
 
-        // Instrucción simple
-        block.push_back(parseLine(line));
-        index++;
+        // Cuerpo: hasta su frase de parada, sin consumirla
+        if (cursor.atEnd() || endsBody(block.kind, cursor.phrase())) {
+            closeBlock(ctx);
+        }
+        else if (startsSequence(cursor.phrase())) {
+            ctx.blocks.push_back(OpenBlock());
+        }
+        else {
+            ctx.pending.push_back(parseLine(ctx));
+        }
     }
-
-    return block;
+    return true;
 }
 
-// ==================== PARSE DE UNA LÍNEA ====================
-
-Instruction NaturalLanguageProcessor::parseLine(const QString& line)
+bool NaturalLanguageProcessor::openBlock(ParseContext& ctx)
 {
-    Instruction instruction;
-    instruction.type = detectInstructionType(line);
-
-    // Determinar keyword: usar frases clave si aplican
-    if (line.startsWith("definir funcion"))
-        instruction.keyword = "definir funcion";
-    else if (line.startsWith("llamar funcion"))
-        instruction.keyword = "llamar funcion";
-    else if (line.startsWith("comenzar programa"))
-        instruction.keyword = "comenzar programa";
-    else if (line.startsWith("terminar programa"))
-        instruction.keyword = "terminar programa";
-    else if (line.startsWith("fin funcion"))
-        instruction.keyword = "fin funcion";
-    else if (line.startsWith("hasta que"))
-        instruction.keyword = "hasta que";
-    else
-        instruction.keyword = line.section(' ', 0, 0);  // primera palabra
-
-    instruction.arguments = line.split(" ", Qt::SkipEmptyParts);
-    return instruction;
-}
+    BlockKind kind;
+    switch (ctx.cursor.phrase()) {
+    case Phrase::Si:             kind = BlockKind::If; break;
+    case Phrase::Mientras:       kind = BlockKind::While; break;
+    case Phrase::Para:           kind = BlockKind::For; break;
+    case Phrase::Repetir:
+    case Phrase::RepetirHasta:   kind = BlockKind::Repeat; break;
+    case Phrase::DefinirFuncion: kind = BlockKind::Function; break;
+    default:                     return false;
+    }
 
-// ==================== DETECCIÓN DE TIPO ====================
+    OpenBlock block;
+    block.kind = kind;
+    block.header = parseLine(ctx); // avanzar tras 'si ...', 'mientras ...'...
+    block.mark = ctx.pending.size();
+    ctx.blocks.push_back(block);
+    return true;
+}
 
-InstructionType NaturalLanguageProcessor::detectInstructionType(const QString& line)
+void NaturalLanguageProcessor::closeBlock(ParseContext& ctx)
 {
-    const QString lowerLine = line.toLower();
-
-    // Inicio / fin de programa
-    if (lowerLine.startsWith("comenzar programa")) return InstructionType::ProgramStart;
-    if (lowerLine.startsWith("terminar programa")) return InstructionType::ProgramEnd;
-
-    // Funciones
-    if (lowerLine.startsWith("definir funcion")) return InstructionType::FunctionDefinition;
-    if (lowerLine.startsWith("llamar funcion")) return InstructionType::FunctionCall;
+    LineCursor& cursor = ctx.cursor;
+
+    OpenBlock block = ctx.blocks.back();
+    ctx.blocks.pop_back();
+    block.header.nested = commitPending(ctx, block.mark);
+    ctx.pending.push_back(block.header);
+
+    switch (block.kind) {
+    // ---- IF / ELSE ----
+    case BlockKind::If:
+        // ¿Hay 'sino'? Su cuerpo llega hasta 'fin si'
+        if (cursor.at(Phrase::Sino)) {
+            OpenBlock elseBlock;
+            elseBlock.kind = BlockKind::Else;
+            elseBlock.header = parseLine(ctx); // avanzar tras 'sino'
+            elseBlock.mark = ctx.pending.size();
+            ctx.blocks.push_back(elseBlock);
+            return;
+        }
+        [[fallthrough]];
+    case BlockKind::Else:
+        if (cursor.at(Phrase::FinSi)) cursor.advance();
+        break;
+
+    // ---- WHILE / FOR / FUNCTION ----
+    case BlockKind::While:
+        if (cursor.at(Phrase::FinMientras)) cursor.advance();
+        break;
+    case BlockKind::For:
+        if (cursor.at(Phrase::FinPara)) cursor.advance();
+        break;
+    case BlockKind::Function:
+        if (cursor.at(Phrase::FinFuncion)) cursor.advance();
+        break;
+
+    // ---- DO-WHILE ----  'hasta que' es una instrucción más, tras el cuerpo
+    case BlockKind::Repeat:
+        if (cursor.at(Phrase::Hasta) || cursor.at(Phrase::HastaQue)) {
+            ctx.pending.push_back(parseLine(ctx));
+        }
+        break;
 
-    // Control
-    if (lowerLine.startsWith("si") || lowerLine.startsWith("sino") ||
-        lowerLine.startsWith("mientras") || lowerLine.startsWith("para") ||
-        lowerLine.startsWith("repetir") || lowerLine.startsWith("hasta")) {
-        return InstructionType::ControlStructure;
+    case BlockKind::Sequence:
+        break;
     }
+}
 
-    // Asignación
-    if (lowerLine.startsWith("asignar")) return InstructionType::Assignment;
+// Frases que terminan el cuerpo de cada bloque (no se consumen aquí)
+bool NaturalLanguageProcessor::endsBody(BlockKind kind, Phrase phrase)
+{
+    switch (kind) {
+    case BlockKind::If:       return phrase == Phrase::Sino || phrase == Phrase::FinSi;
+    case BlockKind::Else:     return phrase == Phrase::FinSi;
+    case BlockKind::While:    return phrase == Phrase::FinMientras;
+    case BlockKind::For:      return phrase == Phrase::FinPara;
+    case BlockKind::Repeat:   return phrase == Phrase::Hasta || phrase == Phrase::HastaQue;
+    case BlockKind::Function: return phrase == Phrase::FinFuncion;
+    case BlockKind::Sequence: break;
+    }
+    return false;
+}
 
-    // Variables
-    if (lowerLine.startsWith("crear variable")) return InstructionType::VariableDeclaration;
+// Mueve al arena, contiguos, los hermanos apilados desde 'mark'
+InstructionList NaturalLanguageProcessor::commitPending(ParseContext& ctx, std::size_t mark)
+{
+    const InstructionList list = ctx.arena.copyArray(ctx.pending.data() + mark, ctx.pending.size() - mark);
+    ctx.pending.resize(mark);
+    return list;
+}
 
-    // IO
-    for (const auto& pair : ioKeywords) {
-        if (lowerLine.startsWith(pair.first)) {
-            return (pair.second == "cin") ? InstructionType::Input : InstructionType::Output;
-        }
-    }
+// ==================== PARSE DE UNA LÍNEA ====================
 
-    // Listas / arreglos
-    if (lowerLine.contains("lista") || lowerLine.contains("arreglo")) return InstructionType::ArrayCreation;
+Instruction NaturalLanguageProcessor::parseLine(ParseContext& ctx)
+{
+    LineCursor& cursor = ctx.cursor;
+    const PhraseMatch& match = cursor.match;
+    const std::string& line = cursor.current();
 
-    // Aritmética
-    for (const auto& pair : arithmeticKeywords) {
-        if (lowerLine.startsWith(pair.first)) return InstructionType::Arithmetic;
+    Instruction instruction;
+    instruction.type = detectInstructionType(match, line);
+    instruction.phrase = match.phrase;
+
+    // Texto y tokens se copian al arena del programa; los buffers del cursor se reutilizan
+    const ArenaSpan<char> chars = ctx.arena.copyArray(line.data(), line.size());
+    instruction.text = std::string_view(chars.items, chars.count);
+    ctx.textLength += instruction.text.size();
+
+    // Cada palabra se interna una sola vez aquí; el generador trabaja con SymbolId
+    const std::vector<Token>& lexedTokens = cursor.lexed.tokens;
+    Token* tokens = ctx.arena.allocateArray<Token>(lexedTokens.size());
+    for (std::size_t i = 0; i < lexedTokens.size(); ++i) {
+        tokens[i] = lexedTokens[i];
+        tokens[i].symbol = ctx.names.intern(instruction.text.substr(tokens[i].begin, tokens[i].length));
     }
+    instruction.tokens = { tokens, lexedTokens.size() };
 
+    // Keyword: la de la frase clave reconocida, o la primera palabra
+    instruction.keyword = match ? match.keyword : instruction.arg(0);
 
-    return InstructionType::Unknown;
+    cursor.advance();
+    return instruction;
 }
 
+// ==================== DETECCIÓN DE TIPO ====================
 
+InstructionType NaturalLanguageProcessor::detectInstructionType(const PhraseMatch& match, std::string_view line)
+{
+    // Inicio/fin de programa, funciones, control, asignación, variables e IO
+    // tienen prioridad sobre listas; la aritmética no.
+    if (match && match.type != InstructionType::Arithmetic) return match.type;
 
-// ==================== INICIALIZAR DICCIONARIOS ====================
+    // Listas / arreglos
+    if (line.find("lista") != std::string_view::npos || line.find("arreglo") != std::string_view::npos) {
+        return InstructionType::ArrayCreation;
+    }
 
-void NaturalLanguageProcessor::initializeDictionaries()
-{
-    // Operaciones aritméticas
-    arithmeticKeywords = {
-        {"sumar", "+"},
-        {"restar", "-"},
-        {"multiplicar", "*"},
-        {"dividir", "/"},
-        {"total", "total"},
-        {"resultado", "resultado"}
-    };
-
-    // Variables y tipos
-    variableKeywords = {
-        {"crear variable", "var"},
-        {"entero", "int"},
-        {"numero entero", "int"},
-        {"numero decimal", "float"},
-        {"decimal", "float"},
-        {"texto", "string"},
-        {"palabra", "string"},
-        {"cadena", "string"},
-        {"caracter", "char"},
-        {"booleano", "bool"},
-        {"valor inicial", "="},
-        {"asignar valor", "="}
-    };
-
-    // Estructuras de control (sin 'y' ni 'o' para evitar falsos positivos)
-    controlKeywords = {
-        {"si", "if"},
-        {"sino", "else"},
-        {"mientras", "while"},
-        {"repetir hasta", "do while"},
-        {"para", "for"},
-        {"igual a", "=="},
-        {"diferente de", "!="},
-        {"mayor que", ">"},
-        {"menor que", "<"}
-        // 🔸 Omitimos 'y' y 'o' aquí a propósito
-    };
-
-    // Entrada / salida
-    ioKeywords = {
-        {"mostrar", "cout"},
-        {"imprimir", "cout"},
-        {"mensaje", "cout"},
-        {"leer", "cin"},
-        {"ingresar valor", "cin"}
-    };
-
-    // Funciones y programa
-    controlKeywords.insert({ "definir funcion", "void" });
-    controlKeywords.insert({ "llamar funcion", "call" });
-    controlKeywords.insert({ "fin funcion", "endfunc" });
-    controlKeywords.insert({ "comenzar programa", "main" });
-    controlKeywords.insert({ "terminar programa", "endmain" });
-    controlKeywords.insert({ "fin", "end" });
-    controlKeywords.insert({ "hasta que", "while" });
+    // Aritmética
+    if (match) return match.type;
 
+    return InstructionType::Unknown;
 }
@@ -1,9 +1,18 @@
 #pragma once
 
-#include <QString>
-#include <QStringList>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <string_view>
 #include <vector>
-#include <map>
+#include "line_reader.h"
+#include "lexer.h"
+#include "keyword_table.h"
+#include "arena.h"
+#include "interner.h"
+#include "conversion_observer.h"
+
+struct ConversionStats;
 
 // Enum que representa tipos de instrucciones reconocidas
 enum class InstructionType {
@@ -22,12 +31,71 @@ enum class InstructionType {
     ProgramEnd
 };
 
-// Estructura para representar una instruccin procesada
+struct Instruction;
+using InstructionList = ArenaSpan<Instruction>;
+
+// Estructura para representar una instruccin procesada.
+// Es solo una vista: el texto, los tokens y los hijos viven en el Arena del
+// Program, as que copiar una instruccin nunca copia su subrbol.
 struct Instruction {
-    InstructionType type;
-    QString keyword;
-    QStringList arguments;
-    std::vector<Instruction> nested;
+    InstructionType type = InstructionType::Unknown;
+    Phrase phrase = Phrase::None; // frase clave inicial reconocida
+    std::string_view keyword;     // literal de KeywordTable o primera palabra de 'text'
+    std::string_view text;        // lnea normalizada (UTF-8)
+    ArenaSpan<Token> tokens;      // argumentos: rangos sobre 'text'
+    InstructionList nested;
+
+    std::ptrdiff_t argCount() const { return std::ptrdiff_t(tokens.size()); }
+
+    std::string_view arg(std::ptrdiff_t i) const {
+        return text.substr(tokens[i].begin, tokens[i].length);
+    }
+
+    std::ptrdiff_t indexOfArg(std::string_view word, std::ptrdiff_t from = 0) const {
+        for (std::ptrdiff_t i = from; i < argCount(); ++i) {
+            if (arg(i) == word) return i;
+        }
+        return -1;
+    }
+
+    bool hasArg(std::string_view word) const { return indexOfArg(word) != -1; }
+
+    std::string_view lastArg() const { return arg(argCount() - 1); }
+
+    SymbolId argSymbol(std::ptrdiff_t i) const { return tokens[i].symbol; }
+
+    // Argumentos desde 'i' hasta el final, separados por un espacio
+    std::string_view argsFrom(std::ptrdiff_t i) const {
+        if (i >= argCount()) return {};
+        return text.substr(tokens[i].begin);
+    }
+};
+
+// Programa parseado. Todo el rbol vive en su propio arena: construirlo y
+// destruirlo cuesta unas pocas reservas grandes. Solo se puede mover.
+struct Program {
+    Arena arena;
+    Interner names;     // palabras de los tokens
+    InstructionList instructions;
+    std::size_t textLength = 0; // bytes de las lneas normalizadas (para estimar la salida)
+
+    // Vaca el programa conservando la memoria del arena y del interner
+    void clear() {
+        arena.reset();
+        names.clear();
+        instructions = {};
+        textLength = 0;
+    }
+};
+
+// Unidad de nivel superior: una instruccin simple o un bloque completo con su
+// cierre. Su parseo solo depende de sus propias lneas, as que se puede
+// reutilizar mientras esas lneas no cambien (ver IncrementalConverter).
+struct ParsedUnit {
+    InstructionList instructions;
+    int firstLine = 0;              // primera lnea no vaca de la unidad (base 0)
+    int nextLine = 0;               // primera lnea no vaca siguiente, o total de lneas
+    bool closesProgram = false;     // cierre suelto fuera de bloque: el parseo termina aqu
 };
 
 class NaturalLanguageProcessor
@@ -36,23 +104,105 @@ public:
     NaturalLanguageProcessor();
     ~NaturalLanguageProcessor();
 
-    // Procesa texto de entrada y devuelve lista de instrucciones
-    std::vector<Instruction> processText(const QString& inputText);
+    // Procesa texto de entrada (UTF-8) y devuelve el programa parseado
+    Program processText(std::string_view inputText);
+
+    // Variantes en streaming: leen y parsean lnea a lnea, sin cargar la entrada
+    // completa (archivos proyectados, dispositivos de Qt: ver QtAdapter).
+    Program processStream(std::istream& stream);
+    Program processLines(LineReader& reader);
+
+    // Igual que processLines, parseando en 'program' (que se vaca antes). Reutilizar
+    // el mismo Program entre conversiones evita reservar de nuevo su arena e interner.
+    void processLines(LineReader& reader, Program& program);
+
+    // Parsea unidad por unidad, guardando instrucciones en 'arena' y palabras en
+    // 'names'. Se detiene al final de la entrada o cuando 'onUnit' devuelve false.
+    using UnitCallback = std::function<bool(const ParsedUnit& unit)>;
+    void processUnits(LineReader& reader, Arena& arena, Interner& names, const UnitCallback& onUnit);
+
+    // Avance y cancelacin cooperativa (nullptr = sin observador)
+    void setObserver(ConversionObserver* conversionObserver) { observer = conversionObserver; }
+
+    // Mtricas de processText/processStream (nullptr = desactivadas)
+    void setStats(ConversionStats* conversionStats) { stats = conversionStats; }
 
 private:
+    // Lnea actual (ya tokenizada) con una lnea de lookahead sobre un LineReader
+    struct LineCursor {
+        LineCursor(LineReader& reader, LexedLine& lexed, ConversionObserver* observer,
+                   ConversionStats* stats = nullptr)
+            : reader(reader), observer(observer), stats(stats), lexed(lexed) { advance(); }
+
+        bool atEnd() const { return !valid; }
+        const std::string& current() const { return lexed.text; }
+        Phrase phrase() const { return match.phrase; }
+        bool at(Phrase p) const { return valid && match.phrase == p; }
+        void advance();     // lee la siguiente lnea no vaca, la tokeniza y la clasifica
+
+        LineReader& reader;
+        ConversionObserver* observer;
+        ConversionStats* stats;     // si no es nullptr, se mide el lexer en 'lexNs'
+        std::int64_t lexNs = 0;
+        int line = -1;      // ndice de la lnea actual; al final, total de lneas ledas
+        int linesRead = 0;
+        LexedLine& lexed;
+        PhraseMatch match;
+        bool valid = false;
+    };
+
+    // Nivel abierto del parser. Un cuerpo (If, Else, While...) llega hasta su
+    // frase de parada sin consumirla; una secuencia (Sequence) repite unidades
+    // hasta un cierre ('fin si'...) que s consume, como el nivel superior.
+    enum class BlockKind : std::uint8_t { Sequence, If, Else, While, For, Repeat, Function };
+
+    struct OpenBlock {
+        BlockKind kind = BlockKind::Sequence;
+        Instruction header;         // instruccin que abre el cuerpo (no aplica a Sequence)
+        std::size_t mark = 0;       // inicio de sus hijos en 'pending'
+    };
+
+    // Estado de un parseo: cursor, arena e interner destino, pila de hermanos
+    // pendientes y pila de niveles abiertos. Cada nivel apila sus hijos en
+    // 'pending' y, al cerrarse, los copia contiguos al arena y libera su tramo.
+    // El anidamiento vive en 'blocks' y no en la pila de llamadas: la
+    // profundidad solo est limitada por la memoria.
+    struct ParseContext {
+        LineCursor& cursor;
+        Arena& arena;
+        Interner& names;
+        std::vector<Instruction>& pending;
+        std::vector<OpenBlock>& blocks;
+        std::size_t textLength = 0;
+    };
+
     // Mtodos auxiliares
-    Instruction parseLine(const QString& line);
-    InstructionType detectInstructionType(const QString& line);
+    // Construye la instruccin de la lnea actual y avanza el cursor
+    Instruction parseLine(ParseContext& ctx);
+    static InstructionType detectInstructionType(const PhraseMatch& match, std::string_view line);
+
+    void parseBlock(ParseContext& ctx);
+
+    // Parsea una unidad; devuelve false si era un cierre ('fin si'...) que termina el bloque
+    bool parseUnit(ParseContext& ctx);
+
+    // Si la lnea actual abre un bloque, la consume y abre su cuerpo
+    bool openBlock(ParseContext& ctx);
+    // Cierra el cuerpo en curso: guarda sus hijos y consume su cierre
+    void closeBlock(ParseContext& ctx);
+    static bool endsBody(BlockKind kind, Phrase phrase);
+    static InstructionList commitPending(ParseContext& ctx, std::size_t mark);
 
-    std::vector<Instruction> parseUntil(const QStringList& lines, int& index, const QStringList& stopTokens);
+    // Pilas de instrucciones pendientes y de niveles abiertos; su capacidad se
+    // reutiliza entre conversiones
+    std::vector<Instruction> pending;
+    std::vector<OpenBlock> openBlocks;
 
-    std::vector<Instruction> parseBlock(const QStringList& lines, int& index);
+    // Lnea en curso ya tokenizada; su capacidad tambin se reutiliza
+    LexedLine lexedLine;
 
-    // Diccionarios de palabras clave
-    std::map<QString, QString> arithmeticKeywords;
-    std::map<QString, QString> variableKeywords;
-    std::map<QString, QString> controlKeywords;
-    std::map<QString, QString> ioKeywords;
+    ConversionObserver* observer = nullptr;
+    ConversionStats* stats = nullptr;
 
-    void initializeDictionaries();
+    static void countInstructions(InstructionList instructions, ConversionStats& stats);
 };
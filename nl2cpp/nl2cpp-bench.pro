@@ -0,0 +1,24 @@
+# Benchmarks por etapa sobre programas sinteticos (solo QtCore).
+# Compilar y medir en Linux:
+#   qmake6 nl2cpp-bench.pro && make -j"$(nproc)"
+#   ./nl2cpp-bench --sizes 1000,5000,20000 -o resultados.json
+
+TEMPLATE = app
+TARGET = nl2cpp-bench
+
+QT = core
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+
+# stdafx.h incluye QtCore en lugar de QtWidgets
+DEFINES += NL2CPP_CORE_ONLY
+PRECOMPILED_HEADER = stdafx.h
+
+include(nl2cpp-core.pri)
+
+HEADERS += \
+    corpus_generator.h
+
+SOURCES += \
+    bench_main.cpp \
+    corpus_generator.cpp
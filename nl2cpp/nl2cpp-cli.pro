@@ -0,0 +1,26 @@
+# Conversor por linea de comandos (solo QtCore, sin QtWidgets).
+# Compilar en Linux:  qmake6 nl2cpp-cli.pro && make -j"$(nproc)"
+
+TEMPLATE = app
+TARGET = nl2cpp-cli
+
+QT = core
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+# stdafx.h incluye QtCore en lugar de QtWidgets
+DEFINES += NL2CPP_CORE_ONLY
+PRECOMPILED_HEADER = stdafx.h
+
+include(nl2cpp-core.pri)
+
+HEADERS += \
+    batch_converter.h \
+    conversion_cache.h \
+    qt_adapter.h
+
+SOURCES += \
+    batch_converter.cpp \
+    cli_main.cpp \
+    conversion_cache.cpp \
+    qt_adapter.cpp
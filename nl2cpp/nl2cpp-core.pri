@@ -0,0 +1,42 @@
+# Nucleo del conversor: C++17 y UTF-8, sin dependencias de Qt.
+# Lo incluyen nl2cpp-core.pro (biblioteca estatica) y las herramientas Qt;
+# el puente con QString y QIODevice esta en qt_adapter.h.
+
+HEADERS += \
+    $$PWD/arena.h \
+    $$PWD/code_generator.h \
+    $$PWD/code_sink.h \
+    $$PWD/conversion_observer.h \
+    $$PWD/conversion_stats.h \
+    $$PWD/converter.h \
+    $$PWD/emit_template.h \
+    $$PWD/flat_map.h \
+    $$PWD/incremental_converter.h \
+    $$PWD/interner.h \
+    $$PWD/keyword_table.h \
+    $$PWD/lexer.h \
+    $$PWD/line_reader.h \
+    $$PWD/natural_language_processor.h \
+    $$PWD/output_cache.h \
+    $$PWD/project_converter.h \
+    $$PWD/stdafx.h \
+    $$PWD/utf8.h \
+    $$PWD/worker_pool.h
+
+SOURCES += \
+    $$PWD/arena.cpp \
+    $$PWD/code_generator.cpp \
+    $$PWD/code_sink.cpp \
+    $$PWD/conversion_stats.cpp \
+    $$PWD/converter.cpp \
+    $$PWD/emit_template.cpp \
+    $$PWD/incremental_converter.cpp \
+    $$PWD/interner.cpp \
+    $$PWD/keyword_table.cpp \
+    $$PWD/lexer.cpp \
+    $$PWD/line_reader.cpp \
+    $$PWD/natural_language_processor.cpp \
+    $$PWD/output_cache.cpp \
+    $$PWD/project_converter.cpp \
+    $$PWD/utf8.cpp \
+    $$PWD/worker_pool.cpp
@@ -0,0 +1,15 @@
+# Nucleo del conversor como biblioteca estatica, sin Qt (para incrustarlo en
+# otros programas). Compilar en Linux:  qmake6 nl2cpp-core.pro && make -j"$(nproc)"
+# API: Converter (std::string_view -> std::string, UTF-8), ver converter.h
+
+TEMPLATE = lib
+TARGET = nl2cpp-core
+
+CONFIG += staticlib c++17
+CONFIG -= qt
+
+# stdafx.h incluye solo la biblioteca estandar
+DEFINES += NL2CPP_NO_QT
+PRECOMPILED_HEADER = stdafx.h
+
+include(nl2cpp-core.pri)
@@ -0,0 +1,27 @@
+# Servicio de conversion de larga duracion (QtCore + QtNetwork, sin QtWidgets).
+# Compilar y probar en Linux:
+#   qmake6 nl2cpp-daemon.pro && make -j"$(nproc)"
+#   ./nl2cpp-daemon --socket nl2cpp &
+#   ./nl2cpp-daemon --client nl2cpp programa.txt
+
+TEMPLATE = app
+TARGET = nl2cpp-daemon
+
+QT = core network
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+# stdafx.h incluye QtCore en lugar de QtWidgets
+DEFINES += NL2CPP_CORE_ONLY
+PRECOMPILED_HEADER = stdafx.h
+
+include(nl2cpp-core.pri)
+
+HEADERS += \
+    conversion_cache.h \
+    conversion_service.h
+
+SOURCES += \
+    conversion_cache.cpp \
+    conversion_service.cpp \
+    daemon_main.cpp
@@ -0,0 +1,21 @@
+# Pruebas del nucleo (sin Qt). Compilar y ejecutar en Linux:
+#   qmake6 nl2cpp-tests.pro && make -j"$(nproc)" && make check
+# Con ThreadSanitizer (la prueba de Converter compartido debe pasar limpia):
+#   qmake6 "CONFIG+=sanitizer sanitize_thread" nl2cpp-tests.pro && make -j"$(nproc)" && make check
+
+TEMPLATE = app
+TARGET = nl2cpp-tests
+
+CONFIG += console c++17 testcase
+CONFIG -= qt app_bundle
+
+# stdafx.h incluye solo la biblioteca estandar
+DEFINES += NL2CPP_NO_QT
+PRECOMPILED_HEADER = stdafx.h
+
+include(nl2cpp-core.pri)
+
+SOURCES += \
+    tests_main.cpp
+
+unix: LIBS += -lpthread
@@ -0,0 +1,88 @@
+﻿#include "stdafx.h"
+#include "output_cache.h"
+#include "lexer.h"
+#include "line_reader.h"
+
+namespace {
+
+// Dos hashes de 64 bits independientes sobre los bytes UTF-8 de las líneas
+// normalizadas (FNV-1a y un multiplicativo con mezcla), estables entre ejecuciones
+class KeyHasher
+{
+public:
+    // La línea pasa por el mismo lexer que el parser, que solo lee su salida
+    void addLine(std::string_view line)
+    {
+        Lexer::lex(line, lexed);
+        if (lexed.tokens.empty()) return;   // líneas en blanco: el parser las salta
+
+        for (char c : lexed.text) add(static_cast<unsigned char>(c));
+        add('\n');
+    }
+
+    CacheKey finish(std::uint64_t fingerprint) const
+    {
+        CacheKey key;
+        key.high = mix(a ^ fingerprint ^ length);
+        key.low = mix(b + fingerprint * 0x9E3779B97F4A7C15ull);
+        return key;
+    }
+
+private:
+    void add(unsigned char c)
+    {
+        a = (a ^ c) * 1099511628211ull;
+        b = (b + c) * 0xC2B2AE3D27D4EB4Full;
+        b ^= b >> 31;
+        ++length;
+    }
+
+    // Finalizador de splitmix64: reparte los bits altos y bajos
+    static std::uint64_t mix(std::uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    std::uint64_t a = 14695981039346656037ull;
+    std::uint64_t b = 0x27D4EB2F165667C5ull;
+    std::uint64_t length = 0;
+    LexedLine lexed;
+};
+
+} // namespace
+
+std::string CacheKey::toHex() const
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(32, '0');
+    for (int i = 0; i < 16; ++i) {
+        hex[15 - i] = digits[(high >> (4 * i)) & 0xF];
+        hex[31 - i] = digits[(low >> (4 * i)) & 0xF];
+    }
+    return hex;
+}
+
+// ==================== CLAVES ====================
+
+CacheKey OutputCache::keyFor(std::string_view inputText, std::uint64_t fingerprint)
+{
+    KeyHasher hasher;
+    std::size_t pos = 0;
+    while (pos < inputText.size()) {
+        std::size_t end = inputText.find('\n', pos);
+        if (end == std::string_view::npos) end = inputText.size();
+        hasher.addLine(inputText.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return hasher.finish(fingerprint);
+}
+
+CacheKey OutputCache::keyFor(LineReader& input, std::uint64_t fingerprint)
+{
+    KeyHasher hasher;
+    std::string_view line;
+    while (input.readLine(line)) hasher.addLine(line);
+    return hasher.finish(fingerprint);
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class LineReader;
+
+// Clave de 128 bits de una entrada normalizada más la huella del generador
+struct CacheKey {
+    std::uint64_t high = 0;
+    std::uint64_t low = 0;
+
+    bool operator==(const CacheKey& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const CacheKey& other) const { return !(*this == other); }
+
+    std::string toHex() const;
+};
+
+struct CacheKeyHash {
+    std::size_t operator()(const CacheKey& key) const { return std::size_t(key.low ^ (key.high >> 7)); }
+};
+
+// Caché de salidas que puede usar Converter, direccionada por contenido.
+//
+// La clave es un hash del texto normalizado por el lexer, línea a línea y sin
+// las líneas en blanco (mayúsculas, tildes, espacios y conectores no cuentan),
+// combinado con la huella del generador: una versión distinta del generador
+// nunca lee salidas viejas. El almacenamiento lo decide cada implementación
+// (ConversionCache guarda en disco); deben poder usarse desde varios hilos.
+class OutputCache
+{
+public:
+    virtual ~OutputCache() = default;
+
+    static CacheKey keyFor(std::string_view inputText, std::uint64_t fingerprint);
+    static CacheKey keyFor(LineReader& input, std::uint64_t fingerprint);
+
+    // Salida guardada para 'key'; false si no está
+    virtual bool lookup(const CacheKey& key, std::string& output) = 0;
+
+    // Guarda 'output' para 'key'. Los fallos se ignoran: la caché nunca hace
+    // fallar una conversión.
+    virtual void store(const CacheKey& key, std::string_view output) = 0;
+};
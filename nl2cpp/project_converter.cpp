@@ -0,0 +1,291 @@
+﻿#include "stdafx.h"
+#include "project_converter.h"
+#include "line_reader.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <numeric>
+
+// ==================== CONSTRUCTOR ====================
+ProjectConverter::ProjectConverter(std::string headerName)
+    : header(std::move(headerName))
+{
+}
+
+ProjectConverter::~ProjectConverter() {}
+
+// ==================== ARCHIVOS ====================
+
+void ProjectConverter::setSource(const std::string& name, std::string text)
+{
+    auto it = std::find_if(units.begin(), units.end(),
+        [&](const std::unique_ptr<Unit>& unit) { return unit->name == name; });
+
+    if (it == units.end()) {
+        units.push_back(std::make_unique<Unit>());
+        units.back()->name = name;
+        it = units.end() - 1;
+    }
+    else if ((*it)->source == text) {
+        return;
+    }
+
+    (*it)->source = std::move(text);
+    (*it)->parsed = false;
+}
+
+bool ProjectConverter::removeSource(const std::string& name)
+{
+    auto it = std::find_if(units.begin(), units.end(),
+        [&](const std::unique_ptr<Unit>& unit) { return unit->name == name; });
+    if (it == units.end()) return false;
+
+    units.erase(it);
+    return true;
+}
+
+// ==================== ACTUALIZACIÓN ====================
+
+void ProjectConverter::update()
+{
+    parseChanged();
+    link();
+    generateUnits();
+    linker.endProgram();
+}
+
+int ProjectConverter::workerCount(std::size_t jobs) const
+{
+    const int threads = threadCount > 0 ? threadCount : WorkerPool::idealThreadCount();
+    return int(std::min<std::size_t>(std::size_t(threads), std::max<std::size_t>(jobs, 1)));
+}
+
+// 1) Cada archivo se parsea con su propio interner y se analiza solo: ninguna
+// de las dos cosas depende de los demás archivos
+void ProjectConverter::parseChanged()
+{
+    std::vector<int> jobs;
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        if (!units[i]->parsed) jobs.push_back(int(i));
+    }
+    lastReparsed = int(jobs.size());
+    if (jobs.empty()) return;
+
+    const int threads = workerCount(jobs.size());
+    std::vector<NaturalLanguageProcessor> processors(threads);
+    std::vector<CodeGenerator> analyzers(threads);
+
+    WorkerPool(jobs, threads, [&](int w, int job) {
+        Unit& unit = *units[job];
+        StringLineReader reader(unit.source);
+        processors[w].processLines(reader, unit.program);
+
+        CodeGenerator& analyzer = analyzers[w];
+        analyzer.beginProgram(unit.program.names);
+        analyzer.analyze(unit.program.instructions, &unit.analysis);
+        analyzer.endProgram();
+
+        unit.hasMain = false;
+        for (const auto& ins : unit.program.instructions) {
+            if (ins.type != InstructionType::FunctionDefinition &&
+                ins.type != InstructionType::ProgramStart && ins.type != InstructionType::ProgramEnd) {
+                unit.hasMain = true;
+                break;
+            }
+        }
+        unit.parsed = true;
+        unit.generated = false;
+        unit.entry.lastArrayName = "lista";
+        unit.entry.lastArraySize = 0;
+        unit.statementsArrayName = "lista";
+        unit.statementsArraySize = 0;
+    }).join();
+}
+
+// 2) Reproduce el análisis de cada archivo, en orden, sobre las palabras del
+// proyecto: el modelo resultante es el del programa concatenado (la última
+// declaración de una variable fija su tipo). Solo copia listas ya calculadas,
+// así que se hace en serie.
+void ProjectConverter::link()
+{
+    names.clear();
+    definedFunctions.clear();
+    definedIn.clear();
+    errors.clear();
+    needsResultado = false;
+    linker.beginProgram(names);
+
+    CodeGenerator::FragmentEffects linked;
+    const Unit* mainUnit = nullptr;
+
+    for (std::size_t u = 0; u < units.size(); ++u) {
+        const Unit& unit = *units[u];
+        const Interner& words = unit.program.names;
+
+        linked.clear();
+        linked.needsString = unit.analysis.needsString;
+        needsResultado = needsResultado || unit.analysis.needsResultado;
+        for (const auto& write : unit.analysis.symbols) {
+            linked.symbols.push_back({ names.intern(words.text(write.first)), write.second });
+        }
+        for (const auto& uses : unit.analysis.functionUses) {
+            const SymbolId function = names.intern(words.text(uses.first));
+            std::vector<SymbolId> mapped;
+            mapped.reserve(uses.second.size());
+            for (SymbolId id : uses.second) mapped.push_back(names.intern(words.text(id)));
+            linked.functionUses.push_back({ function, std::move(mapped) });
+
+            std::uint32_t& definer = definedIn[function];
+            if (definer == 0) {
+                definer = std::uint32_t(u + 1);
+                definedFunctions.push_back(function);
+            }
+            else if (definer == u + 1) {
+                errors.push_back("funcion '" + std::string(names.text(function)) + "' definida dos veces en " + unit.name);
+            }
+            else {
+                errors.push_back("funcion '" + std::string(names.text(function)) + "' definida en " +
+                    units[definer - 1]->name + " y en " + unit.name);
+            }
+        }
+        linker.replay(linked);
+
+        if (unit.hasMain) {
+            if (mainUnit) errors.push_back("sentencias de main en " + mainUnit->name + " y en " + unit.name);
+            else mainUnit = &unit;
+        }
+    }
+    if (!mainUnit && !units.empty()) errors.push_back("ningun archivo tiene sentencias de main");
+    linker.resolveFunctions();
+
+    headerOutput.clear();
+    StringSink out(headerOutput);
+    linker.writeHeader(definedFunctions, out);
+}
+
+// Modelo con el que se genera una unidad: el enlazado, limitado a las palabras
+// que aparecen en ella y a las funciones que define o llama. Así su estado de
+// entrada solo cambia si cambia algo que la unidad usa.
+void ProjectConverter::buildUnitModel(Unit& unit, CodeGenerator::FragmentEffects& model, std::vector<SymbolId>& params) const
+{
+    Interner& words = unit.program.names;
+    model.clear();
+    model.needsResultado = needsResultado;     // lo declara main, para todo el proyecto
+    model.lastArrayName = unit.entry.lastArrayName;
+    model.lastArraySize = unit.entry.lastArraySize;
+
+    const SymbolId ownWords = SymbolId(words.size());
+    for (SymbolId id = 1; id <= ownWords; ++id) {
+        if (const CodeGenerator::CppType* type = linker.symbolType(names.find(words.text(id)))) {
+            model.symbols.push_back({ id, *type });
+        }
+    }
+
+    for (SymbolId function : definedFunctions) {
+        const SymbolId local = words.find(names.text(function));
+        if (local == NoSymbol) continue;
+
+        // Un parámetro puede no aparecer en la unidad que llama: se interna
+        // en ella para poder escribir la llamada
+        linker.functionParameters(function, params);
+        std::vector<SymbolId> mapped;
+        mapped.reserve(params.size());
+        for (SymbolId param : params) {
+            const SymbolId id = words.intern(names.text(param));
+            mapped.push_back(id);
+            model.symbols.push_back({ id, *linker.symbolType(param) });
+        }
+        model.functionUses.push_back({ local, std::move(mapped) });
+    }
+}
+
+// 3) Lo único que una unidad hereda de las anteriores es el último arreglo.
+// Cada una se genera suponiendo el arreglo de entrada de la actualización
+// anterior; al encadenarlas en orden, las que leyeron uno que resultó distinto
+// se vuelven a generar con el correcto (como writeDefinitionsParallel).
+void ProjectConverter::generateUnits()
+{
+    std::vector<int> jobs(units.size());
+    std::iota(jobs.begin(), jobs.end(), 0);
+    std::vector<char> regenerated(units.size(), 0);
+    generatePass(jobs, regenerated);
+
+    std::string arrayName = "lista";
+    int arraySize = 0;
+    std::vector<int> stale;
+    auto follow = [&](int index, std::string& entryName, int& entrySize, const CodeGenerator::FragmentEffects& part) {
+        if (entryName != arrayName || entrySize != arraySize) {
+            if (part.readsArray && (stale.empty() || stale.back() != index)) stale.push_back(index);
+            entryName = arrayName;
+            entrySize = arraySize;
+        }
+        if (part.createsArray) {
+            arrayName = part.lastArrayName;
+            arraySize = part.lastArraySize;
+        }
+    };
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        Unit& unit = *units[i];
+        follow(int(i), unit.entry.lastArrayName, unit.entry.lastArraySize, unit.definitions);
+    }
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        Unit& unit = *units[i];
+        if (unit.hasMain) follow(int(i), unit.statementsArrayName, unit.statementsArraySize, unit.statements);
+    }
+
+    std::sort(stale.begin(), stale.end());
+    stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+    for (int index : stale) units[index]->generated = false;
+    generatePass(stale, regenerated);
+
+    lastRegenerated = int(std::count(regenerated.begin(), regenerated.end(), 1));
+}
+
+// Cada unidad tiene su propio interner y su propio generador: las unidades se
+// generan en paralelo leyendo el modelo enlazado sin modificarlo
+void ProjectConverter::generatePass(const std::vector<int>& jobs, std::vector<char>& regenerated)
+{
+    if (jobs.empty()) return;
+
+    const int threads = workerCount(jobs.size());
+    std::vector<CodeGenerator> generators(threads);
+    std::vector<CodeGenerator::FragmentEffects> models(threads);
+    std::vector<std::vector<SymbolId>> params(threads);
+    std::vector<CodeGenerator::FragmentEffects> arrays(threads);
+
+    WorkerPool(jobs, threads, [&](int w, int job) {
+        Unit& unit = *units[job];
+        CodeGenerator& generator = generators[w];
+        buildUnitModel(unit, models[w], params[w]);
+
+        generator.setThreadCount(1);    // las unidades ya ocupan los hilos
+        generator.beginProgram(unit.program.names);
+        generator.replay(models[w]);
+        generator.resolveFunctions();
+
+        const CodeGenerator::FragmentState entry = generator.fragmentState(true);
+        const bool stale = !unit.generated || entry != unit.entry ||
+            (unit.hasMain && unit.declaresResultado != needsResultado);
+        if (stale) {
+            unit.code.clear();
+            StringSink out(unit.code, CodeGenerator::estimateSize(unit.program));
+            generator.writeUnitPrologue(header, out);
+            generator.writeFunctionDefinitions(unit.program.instructions, out, &unit.definitions);
+            if (unit.hasMain) {
+                arrays[w].clear();
+                arrays[w].lastArrayName = unit.statementsArrayName;
+                arrays[w].lastArraySize = unit.statementsArraySize;
+                generator.replay(arrays[w]);
+
+                generator.writeMainOpen(out);
+                generator.writeStatements(unit.program.instructions, out, &unit.statements);
+                generator.writeEpilogue(out);
+            }
+            unit.entry = entry;
+            unit.declaresResultado = needsResultado;
+            unit.generated = true;
+            regenerated[job] = 1;
+        }
+        generator.endProgram();
+    }).join();
+}
@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "natural_language_processor.h"
+#include "code_generator.h"
+#include "flat_map.h"
+
+// Conversión de un proyecto de varios archivos. Cada archivo es una unidad de
+// traducción propia y las llamadas entre archivos se resuelven como si los
+// archivos estuvieran concatenados en orden: una función definida en un
+// archivo recibe, también desde los demás, las variables del proyecto que usa.
+// Cada actualización tiene tres fases:
+//   1) parseo y análisis de los archivos nuevos o modificados, en paralelo;
+//   2) enlace: une los tipos y las funciones de todos los archivos, resuelve
+//      las firmas y escribe la cabecera común con los prototipos;
+//   3) generación en paralelo de las unidades afectadas: las que cambiaron, o
+//      cuyas variables o funciones usadas cambiaron de tipo o de firma. El
+//      resto conserva su código.
+// El último arreglo ("recorrer la lista") también pasa de un archivo a otro
+// como en el programa concatenado: primero por las definiciones de todos los
+// archivos y después por las sentencias de main. Cada archivo se parsea por
+// separado: un bloque que queda abierto termina al final de su archivo.
+class ProjectConverter
+{
+public:
+    // 'headerName' es el nombre con el que cada unidad incluye la cabecera común
+    explicit ProjectConverter(std::string headerName = "proyecto.h");
+    ~ProjectConverter();
+
+    // Hilos de las fases 1 y 3 (0 = automático)
+    void setThreadCount(int count) { threadCount = count; }
+
+    // Añade un archivo al final del proyecto, o cambia el texto (UTF-8) de uno existente
+    void setSource(const std::string& name, std::string text);
+
+    // Quita un archivo del proyecto; false si no existía
+    bool removeSource(const std::string& name);
+
+    // Parsea, enlaza y genera lo que cambió desde la llamada anterior
+    void update();
+
+    const std::string& headerName() const { return header; }
+    const std::string& headerCode() const { return headerOutput; }
+
+    std::size_t unitCount() const { return units.size(); }
+    const std::string& unitName(std::size_t index) const { return units[index]->name; }
+    const std::string& unitCode(std::size_t index) const { return units[index]->code; }
+
+    // Problemas del enlace: funciones definidas más de una vez, y sentencias de
+    // main en más de un archivo o en ninguno (el proyecto no enlazaría en C++)
+    const std::vector<std::string>& linkErrors() const { return errors; }
+
+    // Archivos reparseados y unidades regeneradas en la última actualización
+    int reparsedUnits() const { return lastReparsed; }
+    int regeneratedUnits() const { return lastRegenerated; }
+
+private:
+    struct Unit {
+        std::string name;
+        std::string source;
+
+        bool parsed = false;                        // 'program' corresponde a 'source'
+        Program program;
+        CodeGenerator::FragmentEffects analysis;    // análisis del archivo solo
+        bool hasMain = false;                       // tiene sentencias fuera de funciones
+
+        bool generated = false;
+        CodeGenerator::FragmentState entry;         // estado con el que se generó 'code'
+        std::string statementsArrayName;            // arreglo de entrada de main
+        int statementsArraySize = 0;
+        bool declaresResultado = false;             // main declara 'resultado'
+        CodeGenerator::FragmentEffects definitions; // arreglo al terminar cada parte
+        CodeGenerator::FragmentEffects statements;
+        std::string code;
+    };
+
+    void parseChanged();
+    void link();
+    void generateUnits();
+    void generatePass(const std::vector<int>& jobs, std::vector<char>& regenerated);
+    void buildUnitModel(Unit& unit, CodeGenerator::FragmentEffects& model, std::vector<SymbolId>& params) const;
+    int workerCount(std::size_t jobs) const;
+
+    std::string header;
+    std::vector<std::unique_ptr<Unit>> units;      // en orden de enlace
+    int threadCount = 0;
+
+    // Modelo enlazado, con las palabras de todo el proyecto
+    Interner names;
+    CodeGenerator linker;
+    std::vector<SymbolId> definedFunctions;         // en orden de definición, sin repetir
+    FlatMap<std::uint32_t> definedIn;               // función -> índice + 1 de su unidad
+    bool needsResultado = false;                    // algún archivo hace aritmética
+
+    std::string headerOutput;
+    std::vector<std::string> errors;
+
+    int lastReparsed = 0;
+    int lastRegenerated = 0;
+};
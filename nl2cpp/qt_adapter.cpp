@@ -0,0 +1,161 @@
+﻿#include "stdafx.h"
+#include "qt_adapter.h"
+#include "converter.h"
+
+#include <QFile>
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+// DeviceSink acumula hasta este tamaño antes de escribir
+constexpr std::size_t flushThreshold = 32 * 1024;
+
+bool startsWithBom(const char* data, qint64 size)
+{
+    return size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0;
+}
+}
+
+// ==================== QIODEVICE ====================
+
+bool DeviceLineReader::readLine(std::string_view& line)
+{
+    // Dispositivos secuenciales (tuberías, sockets): esperar una línea completa
+    while (!device.canReadLine() && device.waitForReadyRead(-1)) {}
+
+    buffer = device.readLine();
+    if (buffer.isEmpty()) return false;     // fin de datos o error
+    ended = buffer.endsWith('\n');
+    if (ended) buffer.chop(1);
+    const qint64 skip = firstLine && startsWithBom(buffer.constData(), buffer.size()) ? 3 : 0;
+    firstLine = false;
+    line = std::string_view(buffer.constData() + skip, std::size_t(buffer.size() - skip));
+    return true;
+}
+
+// ==================== ARCHIVO PROYECTADO ====================
+
+MappedLineReader::MappedLineReader(QIODevice& device)
+    : fallback(device)
+{
+    file = qobject_cast<QFile*>(&device);
+    if (!file || file->isSequential()) return;
+
+    const qint64 offset = file->pos();
+    const qint64 length = file->size() - offset;
+    if (length <= 0) return;
+
+    mapping = file->map(offset, length);
+    if (!mapping) return;
+
+    data = reinterpret_cast<const char*>(mapping);
+    size = length;
+    if (startsWithBom(data, size)) start = 3;
+    pos = start;
+}
+
+MappedLineReader::~MappedLineReader()
+{
+    if (mapping) file->unmap(mapping);
+}
+
+bool MappedLineReader::rewind()
+{
+    if (!data) return false;
+    pos = start;
+    return true;
+}
+
+bool MappedLineReader::readLine(std::string_view& line)
+{
+    if (!data) return fallback.readLine(line);
+    if (pos >= size) return false;
+
+    const char* begin = data + pos;
+    const char* newline = static_cast<const char*>(std::memchr(begin, '\n', std::size_t(size - pos)));
+    qint64 length = newline ? newline - begin : size - pos;
+    pos += length + (newline ? 1 : 0);
+    ended = newline != nullptr;
+    if (length > 0 && begin[length - 1] == '\r') --length;    // como QIODevice::Text
+
+    line = std::string_view(begin, std::size_t(length));
+    return true;
+}
+
+// ==================== ESCRITURA ====================
+
+void DeviceSink::write(std::string_view text)
+{
+    pending.append(text);
+    if (pending.size() >= flushThreshold) flush();
+}
+
+bool DeviceSink::flush()
+{
+    if (!pending.empty()) {
+        if (device.write(pending.data(), qint64(pending.size())) != qint64(pending.size())) failed = true;
+        pending.clear();       // conserva la capacidad
+    }
+    return !failed;
+}
+
+// ==================== TEXTO ====================
+
+std::string QtAdapter::toUtf8(QStringView text)
+{
+    const QByteArray bytes = text.toUtf8();
+    return std::string(bytes.constData(), std::size_t(bytes.size()));
+}
+
+QString QtAdapter::toQString(std::string_view text)
+{
+    return QString::fromUtf8(text.data(), qsizetype(text.size()));
+}
+
+// ==================== CONVERSIÓN ====================
+
+QString QtAdapter::convert(const Converter& converter, const QString& inputText)
+{
+    return toQString(converter.convert(toUtf8(inputText)));
+}
+
+QString QtAdapter::convert(const Converter& converter, const QString& inputText, ConversionObserver& observer)
+{
+    return toQString(converter.convert(toUtf8(inputText), observer));
+}
+
+QString QtAdapter::convert(const Converter& converter, QIODevice& input)
+{
+    MappedLineReader reader(input);
+    return toQString(converter.convert(reader));
+}
+
+void QtAdapter::convert(const Converter& converter, QIODevice& input, CodeSink& output)
+{
+    MappedLineReader reader(input);
+    converter.convert(reader, output);
+}
+
+bool QtAdapter::convertFile(const Converter& converter, const QString& inputPath, const QString& outputPath,
+                            QString* errorMessage)
+{
+    QFile input(inputPath);
+    if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorMessage) *errorMessage = inputPath + ": " + input.errorString();
+        return false;
+    }
+
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (errorMessage) *errorMessage = outputPath + ": " + output.errorString();
+        return false;
+    }
+
+    DeviceSink sink(output);
+    convert(converter, input, sink);
+    if (!sink.flush()) {
+        if (errorMessage) *errorMessage = outputPath + ": " + output.errorString();
+        return false;
+    }
+    return true;
+}
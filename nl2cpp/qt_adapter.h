@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringView>
+#include <string>
+#include <string_view>
+#include "code_sink.h"
+#include "line_reader.h"
+
+class QIODevice;
+class QFile;
+class Converter;
+class ConversionObserver;
+
+// ==================== LECTURA ====================
+
+// Lee líneas UTF-8 de un QIODevice (archivo, proceso, socket...) a medida que
+// llegan. Como MappedLineReader, quita el BOM del comienzo de la primera línea.
+class DeviceLineReader : public LineReader
+{
+public:
+    explicit DeviceLineReader(QIODevice& device) : device(device) {}
+    bool readLine(std::string_view& line) override;
+
+    // La última línea leída terminaba en '\n' (solo la última del texto puede no hacerlo)
+    bool lineEnded() const { return ended; }
+
+private:
+    QIODevice& device;
+    QByteArray buffer;
+    bool firstLine = true;
+    bool ended = false;
+};
+
+// Lee líneas UTF-8 de un archivo proyectado en memoria (QFile::map): cada línea
+// es una vista directa sobre las páginas mapeadas, sin copiar el archivo a un
+// QByteArray ni a un QString. Si 'device' no es un archivo que se pueda mapear
+// (tubería, stdin, archivo vacío...) lee como DeviceLineReader.
+class MappedLineReader : public LineReader
+{
+public:
+    explicit MappedLineReader(QIODevice& device);
+    ~MappedLineReader() override;
+
+    bool readLine(std::string_view& line) override;
+    bool lineEnded() const { return data ? ended : fallback.lineEnded(); }
+
+    // Solo un archivo proyectado se puede volver a leer desde el principio
+    bool rewind() override;
+    bool isMapped() const { return data != nullptr; }
+
+private:
+    DeviceLineReader fallback;
+    QFile* file = nullptr;
+    uchar* mapping = nullptr;
+    const char* data = nullptr;
+    qint64 size = 0;
+    qint64 start = 0;       // después del BOM de la primera línea, si lo hay
+    qint64 pos = 0;
+    bool ended = false;
+};
+
+// ==================== ESCRITURA ====================
+
+// Escribe el código generado en un QIODevice (archivo, tubería, socket...) por bloques
+class DeviceSink : public CodeSink
+{
+public:
+    explicit DeviceSink(QIODevice& device) : device(device) {}
+    ~DeviceSink() override { flush(); }
+
+    void write(std::string_view text) override;
+    bool flush() override;
+
+private:
+    QIODevice& device;
+    std::string pending;
+    bool failed = false;
+};
+
+// ==================== CONVERSOR ====================
+
+// Puente entre el núcleo (UTF-8, sin Qt) y las aplicaciones Qt: pasa los
+// QString de la interfaz a UTF-8 y de vuelta, y convierte desde QIODevice.
+class QtAdapter
+{
+public:
+    static std::string toUtf8(QStringView text);
+    static QString toQString(std::string_view text);
+
+    static QString convert(const Converter& converter, const QString& inputText);
+    static QString convert(const Converter& converter, const QString& inputText, ConversionObserver& observer);
+
+    // Un QFile se lee proyectado en memoria (ver MappedLineReader)
+    static QString convert(const Converter& converter, QIODevice& input);
+    static void convert(const Converter& converter, QIODevice& input, CodeSink& output);
+
+    // Convierte un archivo directamente a disco, sin armar la salida en memoria.
+    // Devuelve false y rellena 'errorMessage' si no se pudo leer o escribir.
+    static bool convertFile(const Converter& converter, const QString& inputPath, const QString& outputPath,
+                            QString* errorMessage = nullptr);
+};
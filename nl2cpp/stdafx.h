@@ -1 +1,10 @@
+#if defined(NL2CPP_NO_QT)
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#elif defined(NL2CPP_CORE_ONLY)
+#include <QtCore>
+#else
 #include <QtWidgets>
+#endif
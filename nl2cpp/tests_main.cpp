@@ -0,0 +1,295 @@
+﻿#include "stdafx.h"
+#include "converter.h"
+#include "conversion_stats.h"
+#include "incremental_converter.h"
+#include "line_reader.h"
+#include "output_cache.h"
+#include "project_converter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Pruebas del núcleo (sin Qt). Cada prueba informa sus fallos por stderr; el
+// programa termina con 1 si alguna falló.
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if (!ok) {
+        ++failures;
+        std::fprintf(stderr, "FALLO: %s\n", what);
+    }
+}
+
+// Programa de prueba determinista: variables, funciones y bloques anidados.
+// 'functions' >= 32 activa la generación de definiciones en paralelo.
+std::string sampleProgram(int seed, int functions)
+{
+    const char* const types[] = { "entero", "decimal", "texto" };
+    std::string text = "comenzar programa\n";
+    for (int v = 0; v < 8; ++v) {
+        text += "crear variable " + std::string(types[(v + seed) % 3]) + " v" + std::to_string(v) + "\n";
+    }
+    for (int f = 0; f < functions; ++f) {
+        text += "definir funcion f" + std::to_string(f) + "\n";
+        text += "  mostrar v" + std::to_string((f + seed) % 8) + "\n";
+        if ((f + seed) % 4 == 0) text += "  crear lista de " + std::to_string(f + 1) + " elementos\n";
+        if ((f + seed) % 5 == 0) text += "  recorrer la lista\n";
+        text += "fin funcion\n";
+    }
+    for (int i = 0; i < 20; ++i) {
+        const std::string v = "v" + std::to_string((i * 3 + seed) % 8);
+        switch ((i + seed) % 5) {
+        case 0: text += "si " + v + " mayor que " + std::to_string(i) + "\n  mostrar \"si\"\nsino\n  mostrar " + v + "\nfin si\n"; break;
+        case 1: text += "mientras " + v + " menor que 10\n  sumar " + v + " mas 1\nfin mientras\n"; break;
+        case 2: text += "para i desde 1 hasta " + std::to_string(i + 2) + "\n  mostrar i\nfin para\n"; break;
+        case 3: text += "leer " + v + "\n"; break;
+        default: text += "llamar funcion f" + std::to_string(functions ? i % functions : 0) + "\n"; break;
+        }
+    }
+    text += "terminar programa\n";
+    return text;
+}
+
+// ==================== CONVERTER COMPARTIDO ====================
+
+// Un único Converter const convierte desde varios hilos a la vez entradas
+// distintas; cada salida debe ser la de la conversión en un solo hilo. Pensada
+// para correr también con ThreadSanitizer (ver nl2cpp-tests.pro).
+void testSharedConverter()
+{
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 24; ++i) inputs.push_back(sampleProgram(i, i % 3 == 0 ? 40 : i % 7));
+
+    std::vector<std::string> expected;
+    {
+        Converter single;
+        single.setThreadCount(1);
+        for (const std::string& input : inputs) expected.push_back(single.convert(input));
+    }
+
+    ConversionStats stats;
+    Converter shared;
+    shared.setStats(&stats);
+    shared.setThreadCount(2);   // definiciones en paralelo dentro de cada conversión
+
+    const int threads = 8;
+    const int rounds = 12;
+    std::atomic<int> mismatches{ 0 };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int r = 0; r < rounds; ++r) {
+                const std::size_t i = std::size_t(t * 5 + r) % inputs.size();
+                if (shared.convert(inputs[i]) != expected[i]) ++mismatches;
+            }
+            // Lote en el mismo espacio de trabajo
+            std::vector<std::string> outputs;
+            shared.convertBatch(inputs, outputs);
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                if (outputs[i] != expected[i]) ++mismatches;
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    check(mismatches == 0, "Converter compartido: salida distinta de la conversion en un hilo");
+    check(stats.conversions == threads * (rounds + int(inputs.size())), "Converter compartido: metricas incompletas");
+}
+
+// ==================== ANIDAMIENTO PROFUNDO ====================
+
+// 'repetir' con 'levels' bloques si/mientras alternados, uno dentro de otro
+std::string nestedProgram(int levels)
+{
+    std::string text = "comenzar programa\ncrear variable entero x\nrepetir\n";
+    for (int d = 0; d < levels; ++d) text += (d % 2) ? "mientras x menor que 10\n" : "si x mayor que 0\n";
+    text += "mostrar x\n";
+    for (int d = levels - 1; d >= 0; --d) text += (d % 2) ? "fin mientras\n" : "fin si\n";
+    text += "hasta que x igual a 0\nterminar programa\n";
+    return text;
+}
+
+// Cuenta bytes y bloques abiertos sin guardar la salida: con N niveles la
+// sangría sola ocupa del orden de N² bytes
+class BlockCountingSink : public CodeSink
+{
+public:
+    void write(std::string_view text) override
+    {
+        bytes += text.size();
+        if (text.size() >= 2 && text.substr(text.size() - 2) == "{\n") ++blocks;
+    }
+
+    std::size_t bytes = 0;
+    int blocks = 0;
+};
+
+// El parser y el generador recorren el anidamiento con pilas propias: 100 000
+// niveles no desbordan la pila. Cómo escala el tiempo lo mide nl2cpp-bench
+// (--nesting), no estas pruebas.
+void testDeepNesting()
+{
+    const int levels = 100000;
+    NaturalLanguageProcessor processor;
+    CodeGenerator generator;
+    Program program;
+    const std::string text = nestedProgram(levels);
+    StringLineReader reader(text);
+    processor.processLines(reader, program);
+
+    BlockCountingSink sink;
+    generator.generateCode(program, sink);
+    check(sink.blocks == levels + 2, "anidamiento: faltan bloques en la salida (main + repetir + niveles)");
+}
+
+// ==================== FRASES CLAVE ====================
+
+// '(', ':' y ',' terminan una frase clave igual que un espacio; "sistema" no es "si"
+void testKeywordBoundaries()
+{
+    const Converter converter;
+    const std::string code = converter.convert(
+        "comenzar programa\ncrear variable entero x\nsi(x > 3)\nmostrar: \"hola\"\nimprimir,x\nfin si\n"
+        "sistema x\nterminar programa\n");
+    check(code.find("if ((x > 3)) {") != std::string::npos, "frases clave: 'si(' no abre el bloque");
+    check(code.find("cout << \"hola\" << endl;") != std::string::npos, "frases clave: 'mostrar:' no se reconoce");
+    check(code.find("cout << x << endl;") != std::string::npos, "frases clave: 'imprimir,' no se reconoce");
+    check(code.find("if (") == code.rfind("if ("), "frases clave: 'sistema' se tomo como 'si'");
+}
+
+// ==================== TIPOS ====================
+
+// Cada construcción con sus palabras de tipo y su precedencia: en una
+// declaración 'entero' manda, y los arreglos no aceptan booleanos
+void testTypeWords()
+{
+    const Converter converter;
+    const std::string code = converter.convert(
+        "comenzar programa\ncrear variable entero texto x\ncrear variable decimales y\n"
+        "crear variable booleano z\ncrear lista de booleanos con 3 elementos\n"
+        "crear lista de caracteres letras con 2 elementos\nterminar programa\n");
+    check(code.find("int x;") != std::string::npos, "tipos: 'entero' no manda en la declaracion");
+    check(code.find("int y;") != std::string::npos, "tipos: la declaracion acepta 'decimales'");
+    check(code.find("bool z;") != std::string::npos, "tipos: 'booleano' no declara bool");
+    check(code.find("int lista[3]") != std::string::npos, "tipos: el arreglo acepta 'booleanos'");
+    check(code.find("char letras[2]") != std::string::npos, "tipos: el arreglo no acepta 'caracteres'");
+}
+
+// ==================== CONVERSIÓN EN VIVO ====================
+
+// Ediciones de líneas al azar (como las que llegan del editor) contra la
+// conversión completa del texto editado
+void testLineEdits()
+{
+    const char* const snippets[] = {
+        "si v1 mayor que 2", "fin si", "mientras v2 menor que 3", "fin mientras", "definir funcion g",
+        "fin funcion", "mostrar v3", "crear lista de 5 elementos", "recorrer la lista", "", "sumar v4 mas 1"
+    };
+    std::vector<std::string> lines;
+    const std::string sample = sampleProgram(3, 6);
+    for (std::size_t pos = 0; pos < sample.size();) {
+        const std::size_t end = sample.find('\n', pos);
+        lines.push_back(sample.substr(pos, end - pos));
+        pos = end + 1;
+    }
+
+    auto join = [](const std::vector<std::string>& parts) {
+        std::string text;
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            if (i) text += '\n';
+            text += parts[i];
+        }
+        return text;
+    };
+
+    const Converter converter;
+    IncrementalConverter live;
+    live.update(join(lines));
+
+    std::uint32_t state = 12345;
+    auto next = [&state](std::uint32_t range) {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) % range;
+    };
+
+    int mismatches = 0;
+    for (int step = 0; step < 300; ++step) {
+        const int first = int(next(std::uint32_t(lines.size())));
+        const int count = 1 + int(next(std::uint32_t(std::min<std::size_t>(3, lines.size() - first))));
+        std::vector<std::string> replacement(1 + next(3));
+        for (std::string& line : replacement) line = snippets[next(std::uint32_t(std::size(snippets)))];
+
+        lines.erase(lines.begin() + first, lines.begin() + first + count);
+        lines.insert(lines.begin() + first, replacement.begin(), replacement.end());
+
+        const std::string text = join(lines);
+        if (live.replaceLines(first, count, join(replacement)) != converter.convert(text)) ++mismatches;
+        if (live.lineCount() != int(lines.size())) ++mismatches;
+    }
+    check(mismatches == 0, "en vivo: replaceLines no coincide con la conversion completa");
+}
+
+// ==================== CACHÉ ====================
+
+// La clave sale del texto normalizado: entradas que el parser no distingue
+// comparten clave, y un cambio dentro de un literal la cambia
+void testCacheKey()
+{
+    const CacheKey key = OutputCache::keyFor("Mostrar  Área\n\nsumar x y 2\n", 7);
+    check(key == OutputCache::keyFor("  mostrar area\r\nsumar x 2", 7), "cache: la clave depende del formato");
+    check(key != OutputCache::keyFor("mostrar area\nsumar x 2\n", 8), "cache: la clave ignora la huella");
+    check(OutputCache::keyFor("mostrar \"A\"\n", 7) != OutputCache::keyFor("mostrar \"a\"\n", 7),
+          "cache: la clave ignora el contenido de un literal");
+}
+
+// ==================== PROYECTOS ====================
+
+// El último arreglo pasa de un archivo a otro como en el programa
+// concatenado: main, en el primer archivo, recorre el arreglo que crea una
+// función del segundo, y lo vuelve a generar cuando ese arreglo cambia
+void testProjectArray()
+{
+    ProjectConverter project;
+    project.setThreadCount(2);
+    project.setSource("usa.txt", "comenzar programa\nllamar funcion preparar\nrecorrer la lista\nterminar programa\n");
+    project.setSource("arr.txt", "definir funcion preparar\n  crear lista de enteros con 4 elementos datos\nfin funcion\n");
+    project.update();
+    check(project.linkErrors().empty(), "proyecto: errores de enlace inesperados");
+    check(project.unitCode(0).find("i < 4; i++") != std::string::npos &&
+          project.unitCode(0).find("datos[i]") != std::string::npos,
+          "proyecto: main no recorre el arreglo creado en otro archivo");
+
+    project.setSource("arr.txt", "definir funcion preparar\n  crear lista de enteros con 6 elementos datos\nfin funcion\n");
+    project.update();
+    check(project.regeneratedUnits() == 2, "proyecto: main no se regenero al cambiar el arreglo");
+    check(project.unitCode(0).find("i < 6; i++") != std::string::npos,
+          "proyecto: main recorre el arreglo anterior");
+}
+
+} // namespace
+
+int main()
+{
+    testSharedConverter();
+    testDeepNesting();
+    testKeywordBoundaries();
+    testTypeWords();
+    testCacheKey();
+    testLineEdits();
+    testProjectArray();
+
+    if (failures) {
+        std::fprintf(stderr, "%d fallos\n", failures);
+        return 1;
+    }
+    std::printf("todas las pruebas pasaron\n");
+    return 0;
+}
@@ -0,0 +1,72 @@
+﻿#include "stdafx.h"
+#include "utf8.h"
+
+namespace Utf8 {
+
+// ==================== PROPIEDADES ====================
+
+bool isSpace(char32_t c)
+{
+    if (c < 0x80) return c == ' ' || (c >= '\t' && c <= '\r');
+    switch (c) {
+    case 0x0085: case 0x00A0: case 0x1680:
+    case 0x2028: case 0x2029: case 0x202F: case 0x205F: case 0x3000:
+        return true;
+    default:
+        return c >= 0x2000 && c <= 0x200A;
+    }
+}
+
+char32_t toLower(char32_t c)
+{
+    if (c < 0x80) return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+
+    // Latin-1
+    if ((c >= 0xC0 && c <= 0xDE) && c != 0xD7) return c + 0x20;
+
+    // Latin Extended-A: pares mayúscula/minúscula consecutivos
+    if (c == 0x0130) return 'i';
+    if (c >= 0x0100 && c <= 0x0137) return (c & 1) ? c : c + 1;
+    if (c >= 0x0139 && c <= 0x0148) return (c & 1) ? c + 1 : c;
+    if (c >= 0x014A && c <= 0x0177) return (c & 1) ? c : c + 1;
+    if (c == 0x0178) return 0xFF;
+    if (c >= 0x0179 && c <= 0x017E) return (c & 1) ? c + 1 : c;
+
+    // Griego (con las vocales acentuadas) y cirílico
+    if (c == 0x0386) return 0x03AC;
+    if (c >= 0x0388 && c <= 0x038A) return c + 0x25;
+    if (c == 0x038C) return 0x03CC;
+    if (c == 0x038E || c == 0x038F) return c + 0x3F;
+    if (c >= 0x0391 && c <= 0x03AB && c != 0x03A2) return c + 0x20;
+    if (c >= 0x0400 && c <= 0x040F) return c + 0x50;
+    if (c >= 0x0410 && c <= 0x042F) return c + 0x20;
+
+    return c;
+}
+
+// ==================== TEXTO ====================
+
+std::string_view trimmed(std::string_view text)
+{
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    while (begin < end) {
+        char32_t c;
+        const int length = decode(begin, end, c);
+        if (!isSpace(c)) break;
+        begin += length;
+    }
+
+    // Hacia atrás: retrocede hasta el byte inicial de cada carácter
+    while (end > begin) {
+        const char* start = end - 1;
+        while (start > begin && (static_cast<unsigned char>(*start) & 0xC0) == 0x80) --start;
+        char32_t c;
+        if (start + decode(start, end, c) != end || !isSpace(c)) break;
+        end = start;
+    }
+    return std::string_view(begin, std::size_t(end - begin));
+}
+
+} // namespace Utf8
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Utilidades de UTF-8 del núcleo: decodificar y codificar un carácter y las
+// pocas propiedades Unicode que necesita el lexer (espacios y minúsculas).
+namespace Utf8 {
+
+// Valor de 'decode' para una secuencia inválida o cortada
+constexpr char32_t invalid = 0x110000;
+
+// Decodifica el carácter que empieza en 'p' (p < end) y devuelve cuántos bytes
+// ocupa. Una secuencia inválida ocupa 1 byte y da 'invalid'.
+inline int decode(const char* p, const char* end, char32_t& codePoint)
+{
+    const unsigned char lead = static_cast<unsigned char>(p[0]);
+    if (lead < 0x80) {
+        codePoint = lead;
+        return 1;
+    }
+
+    int length = 0;
+    char32_t value = 0;
+    char32_t minimum = 0;
+    if (lead >= 0xC2 && lead <= 0xDF)      { length = 2; value = lead & 0x1F; minimum = 0x80; }
+    else if (lead >= 0xE0 && lead <= 0xEF) { length = 3; value = lead & 0x0F; minimum = 0x800; }
+    else if (lead >= 0xF0 && lead <= 0xF4) { length = 4; value = lead & 0x07; minimum = 0x10000; }
+
+    if (length == 0 || end - p < length) {
+        codePoint = invalid;
+        return 1;
+    }
+    for (int i = 1; i < length; ++i) {
+        const unsigned char next = static_cast<unsigned char>(p[i]);
+        if ((next & 0xC0) != 0x80) {
+            codePoint = invalid;
+            return 1;
+        }
+        value = (value << 6) | (next & 0x3F);
+    }
+
+    // Formas sobrelargas, sustitutos UTF-16 y valores fuera de rango
+    if (value < minimum || (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF) {
+        codePoint = invalid;
+        return 1;
+    }
+    codePoint = value;
+    return length;
+}
+
+// Escribe 'codePoint' en 'out' (hasta 4 bytes) y devuelve cuántos escribió
+inline int encode(char32_t codePoint, char* out)
+{
+    if (codePoint < 0x80) {
+        out[0] = char(codePoint);
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = char(0xC0 | (codePoint >> 6));
+        out[1] = char(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = char(0xE0 | (codePoint >> 12));
+        out[1] = char(0x80 | ((codePoint >> 6) & 0x3F));
+        out[2] = char(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    out[0] = char(0xF0 | (codePoint >> 18));
+    out[1] = char(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = char(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = char(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+// Espacio en blanco de Unicode (categorías Zs, Zl y Zp, más los de control)
+bool isSpace(char32_t codePoint);
+
+// Minúscula simple de los alfabetos latino, griego y cirílico; el resto se
+// conserva. Nunca ocupa más bytes en UTF-8 que el carácter original.
+char32_t toLower(char32_t codePoint);
+
+// Recorta los espacios (isSpace) de los dos extremos
+std::string_view trimmed(std::string_view text);
+
+} // namespace Utf8
@@ -0,0 +1,75 @@
+﻿#include "stdafx.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// ==================== COLA ====================
+
+bool WorkQueue::popFront(int& job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.empty()) return false;
+    job = jobs.front();
+    jobs.pop_front();
+    return true;
+}
+
+bool WorkQueue::stealBack(int& job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.empty()) return false;
+    job = jobs.back();
+    jobs.pop_back();
+    return true;
+}
+
+// ==================== POOL ====================
+
+WorkerPool::WorkerPool(const std::vector<int>& jobs, int threadCount, Work work)
+    : work(std::move(work))
+{
+    const int total = int(jobs.size());
+    threadCount = std::min(threadCount, total);
+
+    queues.reserve(threadCount);
+    for (int w = 0; w < threadCount; ++w) {
+        auto queue = std::make_unique<WorkQueue>();
+        const int begin = int(std::int64_t(total) * w / threadCount);
+        const int end = int(std::int64_t(total) * (w + 1) / threadCount);
+        for (int i = begin; i < end; ++i) queue->jobs.push_back(jobs[i]);
+        queues.push_back(std::move(queue));
+    }
+
+    threads.reserve(threadCount);
+    for (int w = 0; w < threadCount; ++w) {
+        threads.emplace_back(&WorkerPool::loop, this, w);
+    }
+}
+
+int WorkerPool::idealThreadCount()
+{
+    return std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+void WorkerPool::join()
+{
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void WorkerPool::loop(int self)
+{
+    const int threadCount = int(queues.size());
+    int job = -1;
+    for (;;) {
+        bool found = queues[self]->popFront(job);
+        for (int k = 1; !found && k < threadCount; ++k) {
+            found = queues[(self + k) % threadCount]->stealBack(job);
+        }
+        // No se agregan trabajos después de arrancar: colas vacías = terminado
+        if (!found) break;
+        work(self, job);
+    }
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Cola de trabajos de un hilo: el dueño toma del frente, los ladrones del final
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<int> jobs;
+
+    bool popFront(int& job);
+    bool stealBack(int& job);
+};
+
+// Reparte 'jobs' entre los hilos en tramos contiguos; el robo equilibra el resto.
+// 'work(worker, job)' corre en los hilos; join() espera a que terminen todos.
+// Lo usan BatchConverter (un trabajo por archivo) y CodeGenerator (uno por función).
+class WorkerPool {
+public:
+    using Work = std::function<void(int worker, int job)>;
+
+    WorkerPool(const std::vector<int>& jobs, int threadCount, Work work);
+    ~WorkerPool() { join(); }
+
+    void join();
+
+    // Núcleos disponibles (al menos 1)
+    static int idealThreadCount();
+
+private:
+    void loop(int self);
+
+    Work work;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+};